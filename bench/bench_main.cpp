@@ -0,0 +1,239 @@
+/**
+ * @file bench_main.cpp
+ * @brief Benchmark driver: full pipeline over a grid of synthetic datasets
+ *
+ * Usage:
+ *   bench [grid.txt] [results.csv]        run every grid point, append one CSV row per run
+ *   bench --generate grid.txt out.csv     write the dataset of the first grid point
+ *   bench --perfcheck [baseline.json] [--runs N] [--update]
+ *                                         regression gate of the main executable (see perfcheck.h);
+ *                                         run from the build directory, exits 1 on a regression
+ *   bench --check [name]                  correctness checks (see checks.h; all if no name),
+ *                                         exits 1 if one fails
+ *
+ * The grid file uses the key=value format of config.txt, where every value may be a
+ * comma-separated list; the Cartesian product of all lists is run `repetitions` times.
+ * Keys: instances, features, skew, pattern_count, pattern_size, pattern_prevalence,
+ * cluster_spread, noise_density, neighbor_distance, min_prevalence, mining_strategy,
+ * max_pattern_size, seed, repetitions.
+ *
+ * peak_rss_mb is the high-water mark of the bench process so far; run one grid point per
+ * process when exact per-dataset peaks are needed.
+ */
+
+#include "synthetic_data.h"
+#include "perfcheck.h"
+#include "checks.h"
+#include "spatial_index.h"
+#include "neighborhood_mgr.h"
+#include "NRTree.h"
+#include "miner.h"
+#include "feature_ranking.h"
+#include "run_report.h"
+#include "telemetry.h"
+#include "constants.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Grid = std::map<std::string, std::vector<std::string>>;
+
+// Defaults of every grid key (one value each)
+Grid defaultGrid() {
+    return {
+        { "instances", { "100000" } },
+        { "features", { "20" } },
+        { "skew", { "1.0" } },
+        { "pattern_count", { "5" } },
+        { "pattern_size", { "4" } },
+        { "pattern_prevalence", { "0.5" } },
+        { "cluster_spread", { "0.5" } },
+        { "noise_density", { "2.0" } },
+        { "neighbor_distance", { "100" } },
+        { "min_prevalence", { "0.3" } },
+        { "mining_strategy", { "level_wise" } },
+        { "max_pattern_size", { "0" } },
+        { "seed", { "42" } },
+        { "repetitions", { "1" } },
+    };
+}
+
+bool loadGrid(const std::string& path, Grid& grid) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        const size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        const std::string key = line.substr(0, eq);
+        if (!grid.count(key)) {
+            std::cerr << "Warning: unknown grid key '" << key << "' ignored.\n";
+            continue;
+        }
+        std::vector<std::string> values;
+        std::istringstream list(line.substr(eq + 1));
+        std::string value;
+        while (std::getline(list, value, ',')) {
+            if (!value.empty()) values.push_back(value);
+        }
+        if (!values.empty()) grid[key] = values;
+    }
+    return true;
+}
+
+// Every combination of grid values (repetitions is not part of a point)
+std::vector<std::map<std::string, std::string>> gridPoints(const Grid& grid) {
+    std::vector<std::map<std::string, std::string>> points(1);
+    for (const auto& entry : grid) {
+        if (entry.first == "repetitions") continue;
+        std::vector<std::map<std::string, std::string>> expanded;
+        for (const auto& point : points) {
+            for (const auto& value : entry.second) {
+                auto next = point;
+                next[entry.first] = value;
+                expanded.push_back(std::move(next));
+            }
+        }
+        points = std::move(expanded);
+    }
+    return points;
+}
+
+SyntheticConfig syntheticConfig(const std::map<std::string, std::string>& point) {
+    SyntheticConfig config;
+    config.numInstances = std::stoull(point.at("instances"));
+    config.numFeatures = std::stoull(point.at("features"));
+    config.raritySkew = std::stod(point.at("skew"));
+    config.patternCount = std::stoull(point.at("pattern_count"));
+    config.patternSize = std::stoull(point.at("pattern_size"));
+    config.patternPrevalence = std::stod(point.at("pattern_prevalence"));
+    config.clusterSpread = std::stod(point.at("cluster_spread"));
+    config.noiseDensity = std::stod(point.at("noise_density"));
+    config.neighborDistance = std::stod(point.at("neighbor_distance"));
+    config.seed = std::stoull(point.at("seed"));
+    return config;
+}
+
+const char* CSV_PARAMETERS[] = {
+    "instances", "features", "skew", "pattern_count", "pattern_size", "pattern_prevalence",
+    "cluster_spread", "noise_density", "neighbor_distance", "min_prevalence",
+    "mining_strategy", "max_pattern_size", "seed",
+};
+
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--perfcheck") {
+        PerfCheckOptions options;
+        // The main executable is built next to this one
+        std::filesystem::path binDir = std::filesystem::path(argv[0]).parent_path();
+        options.mainPath = ((binDir.empty() ? std::filesystem::path(".") : binDir) / "main").string();
+        for (int i = 2; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--update") options.update = true;
+            else if (arg == "--runs" && i + 1 < argc) options.runs = std::stoi(argv[++i]);
+            else options.baselinePath = arg;
+        }
+        return runPerfCheck(options);
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--check") {
+        if (argc > 2) return runCheck(argv[2]);
+        int status = 0;
+        for (const auto& name : checkNames()) status = std::max(status, runCheck(name));
+        return status;
+    }
+
+    const bool generateOnly = argc > 1 && std::string(argv[1]) == "--generate";
+    const int argOffset = generateOnly ? 2 : 1;
+    const std::string gridPath = (argc > argOffset) ? argv[argOffset] : "./bench/grid.txt";
+    const std::string outputPath = (argc > argOffset + 1) ? argv[argOffset + 1] : "bench_results.csv";
+
+    Grid grid = defaultGrid();
+    if (!loadGrid(gridPath, grid)) {
+        std::cerr << "Warning: grid file " << gridPath << " not found, using defaults.\n";
+    }
+    const std::vector<std::map<std::string, std::string>> points = gridPoints(grid);
+
+    if (generateOnly) {
+        if (!writeSyntheticCsv(syntheticConfig(points.front()), outputPath)) {
+            std::cerr << "Cannot write " << outputPath << ".\n";
+            return 1;
+        }
+        std::cout << "Dataset written to " << outputPath << "\n";
+        return 0;
+    }
+
+    std::ofstream csv(outputPath);
+    if (!csv.is_open()) {
+        std::cerr << "Cannot write " << outputPath << ".\n";
+        return 1;
+    }
+    for (const char* parameter : CSV_PARAMETERS) csv << parameter << ',';
+    csv << "repetition,generate_s,grid_join_s,neighborhood_s,nrtree_s,mining_s,pipeline_s,"
+        << "mining_cpu_s,peak_rss_mb,neighbor_pairs,patterns,largest_pattern\n";
+
+    const int repetitions = std::stoi(grid.at("repetitions").front());
+    for (size_t p = 0; p < points.size(); ++p) {
+        const auto& point = points[p];
+        const SyntheticConfig dataConfig = syntheticConfig(point);
+        const double minPrev = std::stod(point.at("min_prevalence"));
+        MiningOptions options;
+        options.maxPatternSize = std::stoull(point.at("max_pattern_size"));
+        options.strategy = (point.at("mining_strategy") == "depth_first" || point.at("mining_strategy") == "dfs")
+            ? MiningStrategy::DEPTH_FIRST : MiningStrategy::LEVEL_WISE;
+
+        for (int rep = 0; rep < repetitions; ++rep) {
+            const StageTimer generateTimer;
+            const std::vector<SpatialInstance> instances = generateSyntheticInstances(dataConfig);
+            const FeatureRanking featureRanking(instances);
+            const StageStats generateStats = generateTimer.stop("generate");
+
+            const StageTimer joinTimer;
+            SpatialIndex spatialIndex(dataConfig.neighborDistance, Constants::DEFAULT_CELL_SPLIT_THRESHOLD, CoordinateSystem::PLANAR);
+            const auto neighborPairs = spatialIndex.findNeighborPair(instances);
+            const StageStats joinStats = joinTimer.stop("grid_join");
+
+            const StageTimer neighborhoodTimer;
+            NeighborhoodMgr neighborMgr;
+            neighborMgr.buildFromPairs(neighborPairs, featureRanking);
+            const StageStats neighborhoodStats = neighborhoodTimer.stop("neighborhood_build");
+
+            const StageTimer treeTimer;
+            NRTree orderedNRTree;
+            orderedNRTree.build(neighborMgr, featureRanking);
+            const StageStats treeStats = treeTimer.stop("nrtree_build");
+
+            const StageTimer miningTimer;
+            JoinlessMiner miner;
+            const auto patterns = miner.mineColocations(minPrev, orderedNRTree, featureRanking, options);
+            const StageStats miningStats = miningTimer.stop("mining");
+
+            size_t largestPattern = 0;
+            for (const auto& pattern : patterns) largestPattern = std::max(largestPattern, pattern.size());
+
+            for (const char* parameter : CSV_PARAMETERS) csv << point.at(parameter) << ',';
+            csv << rep << ',' << generateStats.wallSeconds << ',' << joinStats.wallSeconds << ','
+                << neighborhoodStats.wallSeconds << ',' << treeStats.wallSeconds << ',' << miningStats.wallSeconds << ','
+                << joinStats.wallSeconds + neighborhoodStats.wallSeconds + treeStats.wallSeconds + miningStats.wallSeconds << ','
+                << miningStats.cpuSeconds << ',' << miningStats.processPeakRSSMB << ',' << neighborPairs.size() << ','
+                << patterns.size() << ',' << largestPattern << '\n';
+            csv.flush();
+
+            std::cout << "[" << (p + 1) << "/" << points.size() << "] rep " << rep
+                << ": " << instances.size() << " instances, " << patterns.size() << " patterns, mining "
+                << miningStats.wallSeconds << " s\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,435 @@
+/**
+ * @file checks.cpp
+ * @brief Implementation of the correctness checks
+ */
+
+#include "checks.h"
+#include "synthetic_data.h"
+#include "mining_session.h"
+#include "data_loader.h"
+#include "spatial_index.h"
+#include "constants.h"
+#include "pattern_mask.h"
+#include "utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <thread>
+#include <utility>
+
+namespace {
+
+using PairSet = std::set<std::pair<instanceID, instanceID>>;
+
+double haversineMeters(const SpatialInstance& a, const SpatialInstance& b) {
+    const double degToRad = std::acos(-1.0) / 180.0;
+    const double sinLat = std::sin(0.5 * (b.y - a.y) * degToRad);
+    const double sinLon = std::sin(0.5 * (b.x - a.x) * degToRad);
+    const double h = sinLat * sinLat + std::cos(a.y * degToRad) * std::cos(b.y * degToRad) * sinLon * sinLon;
+    return 2.0 * Constants::EARTH_RADIUS_METERS * std::asin(std::min(1.0, std::sqrt(h)));
+}
+
+std::pair<instanceID, instanceID> pairKey(const SpatialInstance& a, const SpatialInstance& b) {
+    return (a.id < b.id) ? std::make_pair(a.id, b.id) : std::make_pair(b.id, a.id);
+}
+
+// Instances of features A, B, C with ordinals per feature, at the given lon/lat points
+std::vector<SpatialInstance> makeInstances(const std::vector<std::pair<double, double>>& points) {
+    std::vector<SpatialInstance> instances;
+    uint32_t ordinals[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < points.size(); ++i) {
+        SpatialInstance inst;
+        inst.type = std::string(1, static_cast<char>('A' + i % 3));
+        inst.ordinal = ordinals[i % 3]++;
+        inst.id = inst.type + std::to_string(inst.ordinal + 1);
+        inst.x = points[i].first;
+        inst.y = points[i].second;
+        instances.push_back(inst);
+    }
+    return instances;
+}
+
+// Compare the pairs of findNeighborPair with the expected pairs and print what differs
+bool samePairs(const std::string& name, const std::vector<std::pair<SpatialInstance, SpatialInstance>>& pairs,
+               const PairSet& expected, const std::string& detail, bool ok) {
+    PairSet found;
+    for (const auto& pair : pairs) found.insert(pairKey(pair.first, pair.second));
+
+    ok &= found == expected && found.size() == pairs.size();
+    std::cout << name << ": " << expected.size() << " pairs" << detail << ", found "
+              << pairs.size() << (ok ? " - ok\n" : " - MISMATCH\n");
+    size_t shown = 0;
+    for (const auto& key : expected) {
+        if (!found.count(key) && shown++ < 5) std::cout << "  missing " << key.first << "-" << key.second << "\n";
+    }
+    for (const auto& key : found) {
+        if (!expected.count(key) && shown++ < 10) std::cout << "  extra " << key.first << "-" << key.second << "\n";
+    }
+    if (found.size() != pairs.size()) std::cout << "  " << pairs.size() - found.size() << " duplicate pairs\n";
+    return ok;
+}
+
+// Geodesic findNeighborPair against all pairs by haversine distance; requireCrossing
+// makes the check fail when no expected pair straddles ±180° (the case is meant to test the seam)
+bool matchesBruteForce(const std::string& name, const std::vector<SpatialInstance>& instances, double distance,
+                       bool requireCrossing = true) {
+    const auto pairs = SpatialIndex(distance, Constants::DEFAULT_CELL_SPLIT_THRESHOLD, CoordinateSystem::GEODESIC)
+        .findNeighborPair(instances);
+
+    PairSet expected;
+    size_t crossing = 0;
+    for (size_t i = 0; i < instances.size(); ++i) {
+        for (size_t j = i + 1; j < instances.size(); ++j) {
+            if (instances[i].type == instances[j].type) continue;
+            if (haversineMeters(instances[i], instances[j]) > distance) continue;
+            expected.insert(pairKey(instances[i], instances[j]));
+            if (std::abs(instances[i].x - instances[j].x) > 180.0) ++crossing;
+        }
+    }
+    return samePairs(name, pairs, expected, " (" + std::to_string(crossing) + " across ±180°)",
+                     crossing > 0 || !requireCrossing);
+}
+
+int checkAntimeridian() {
+    std::mt19937_64 rng(7);
+    bool ok = true;
+
+    // Around Fiji: longitudes within ±0.02° of the antimeridian, written as 179.99 and
+    // -179.99 style values
+    {
+        std::uniform_real_distribution<double> lonOffset(-0.02, 0.02);
+        std::uniform_real_distribution<double> lat(-17.02, -16.98);
+        std::vector<std::pair<double, double>> points;
+        for (int i = 0; i < 1500; ++i) {
+            double lon = 180.0 + lonOffset(rng);
+            if (lon > 180.0) lon -= 360.0;
+            points.emplace_back(lon, lat(rng));
+        }
+        ok &= matchesBruteForce("antimeridian", makeInstances(points), 300.0);
+    }
+
+    // Ring around the north pole: every longitude is taken, so the seam of the projection
+    // runs through the data
+    {
+        std::uniform_real_distribution<double> lon(-180.0, 180.0);
+        std::uniform_real_distribution<double> lat(89.97, 89.99);
+        std::vector<std::pair<double, double>> points;
+        for (int i = 0; i < 1500; ++i) points.emplace_back(lon(rng), lat(rng));
+        ok &= matchesBruteForce("polar ring", makeInstances(points), 150.0);
+    }
+
+    // High latitude with a large threshold: great-circle paths bulge toward the pole, so
+    // neighbors are farther apart in longitude than cos(latitude) of either point suggests
+    {
+        std::uniform_real_distribution<double> lon(-180.0, 180.0);
+        std::uniform_real_distribution<double> lat(84.9, 85.0);
+        std::vector<std::pair<double, double>> points;
+        for (int i = 0; i < 1500; ++i) points.emplace_back(lon(rng), lat(rng));
+        ok &= matchesBruteForce("high latitude", makeInstances(points), 600000.0);
+    }
+
+    // Wide latitude band with a threshold of more than 10° of latitude, longitudes away
+    // from ±180°
+    {
+        std::uniform_real_distribution<double> lon(-60.0, 60.0);
+        std::uniform_real_distribution<double> lat(60.0, 80.0);
+        std::vector<std::pair<double, double>> points;
+        for (int i = 0; i < 1500; ++i) points.emplace_back(lon(rng), lat(rng));
+        ok &= matchesBruteForce("wide band", makeInstances(points), 1500000.0, false);
+    }
+
+    // Within metres of the pole: the threshold reaches the pole itself
+    {
+        std::uniform_real_distribution<double> lon(-180.0, 180.0);
+        std::uniform_real_distribution<double> lat(89.9999, 90.0);
+        std::vector<std::pair<double, double>> points;
+        for (int i = 0; i < 1500; ++i) points.emplace_back(lon(rng), lat(rng));
+        ok &= matchesBruteForce("near pole", makeInstances(points), 5.0);
+    }
+    return ok ? 0 : 1;
+}
+
+// Planar findNeighborPair at several split thresholds against all pairs by Euclidean
+// distance. Tight clusters make whole node pairs fall within the threshold (WHOLE), stacks
+// of duplicate points cannot be subdivided, and the sparse background leaves node pairs
+// to skip or scan, so every quadtree join action is exercised
+int checkQuadtreeJoin() {
+    std::mt19937_64 rng(5);
+    const double distance = 10.0;
+    std::vector<std::pair<double, double>> points;
+
+    // Clusters of radius 3 around random centers
+    std::uniform_real_distribution<double> center(0.0, 200.0);
+    std::uniform_real_distribution<double> offset(-3.0, 3.0);
+    for (int c = 0; c < 6; ++c) {
+        const double cx = center(rng), cy = center(rng);
+        for (int i = 0; i < 300; ++i) points.emplace_back(cx + offset(rng), cy + offset(rng));
+    }
+    // Stacks of identical points
+    for (int s = 0; s < 4; ++s) {
+        const double x = center(rng), y = center(rng);
+        for (int i = 0; i < 90; ++i) points.emplace_back(x, y);
+    }
+    // Sparse background
+    for (int i = 0; i < 600; ++i) points.emplace_back(center(rng), center(rng));
+    const std::vector<SpatialInstance> instances = makeInstances(points);
+
+    PairSet expected;
+    for (size_t i = 0; i < instances.size(); ++i) {
+        for (size_t j = i + 1; j < instances.size(); ++j) {
+            if (instances[i].type == instances[j].type) continue;
+            const double dx = instances[i].x - instances[j].x;
+            const double dy = instances[i].y - instances[j].y;
+            if (std::sqrt(dx * dx + dy * dy) > distance) continue;
+            expected.insert(pairKey(instances[i], instances[j]));
+        }
+    }
+
+    bool ok = true;
+    for (const size_t splitThreshold : { size_t{ 0 }, size_t{ 1 }, size_t{ 2 }, Constants::DEFAULT_CELL_SPLIT_THRESHOLD }) {
+        const auto pairs = SpatialIndex(distance, splitThreshold).findNeighborPair(instances);
+        ok &= samePairs("quadtree join (split threshold " + std::to_string(splitThreshold) + ")",
+                        pairs, expected, "", true);
+    }
+    return ok ? 0 : 1;
+}
+
+// Synthetic dataset with planted patterns of size 6 (levels of several MB at minPrev 0.2)
+std::unique_ptr<MiningSession> syntheticSession() {
+    SyntheticConfig dataConfig;
+    dataConfig.numInstances = 40000;
+    dataConfig.numFeatures = 12;
+    dataConfig.patternCount = 3;
+    dataConfig.patternSize = 6;
+    dataConfig.seed = 11;
+    IndexOptions indexOptions;
+    indexOptions.neighborDistance = dataConfig.neighborDistance;
+    return std::unique_ptr<MiningSession>(new MiningSession(generateSyntheticInstances(dataConfig), indexOptions));
+}
+
+// A budget smaller than the tables of a single level: tables are written to disk while
+// the level is generated (no level ever holds more than the budget, including the pair
+// level) and read back as prefixes, without changing the patterns
+int checkSpillBudget() {
+    const auto sessionPtr = syntheticSession();
+    const MiningSession& session = *sessionPtr;
+
+    const double minPrev = 0.2;
+    const MiningResult unlimited = session.mine(minPrev);
+    MiningOptions budgetOptions;
+    budgetOptions.memoryBudgetMB = 1;
+    const MiningResult budgeted = session.mine(minPrev, budgetOptions);
+
+    size_t largestLevelBytes = 0;
+    for (const auto& level : unlimited.levels) largestLevelBytes = std::max(largestLevelBytes, level.peakBytesHeld);
+    size_t spilledTables = 0;
+    bool withinBudget = true;
+    for (const auto& level : budgeted.levels) {
+        spilledTables += level.spilledTables;
+        withinBudget &= level.peakBytesHeld <= budgetOptions.memoryBudgetMB * 1024 * 1024;
+    }
+
+    std::set<Colocation> expected(unlimited.patterns.begin(), unlimited.patterns.end());
+    std::set<Colocation> found(budgeted.patterns.begin(), budgeted.patterns.end());
+    const bool ok = found == expected && largestLevelBytes > budgetOptions.memoryBudgetMB * 1024 * 1024
+        && spilledTables > 0 && withinBudget;
+    std::cout << "spill budget: " << expected.size() << " patterns, largest level "
+              << largestLevelBytes / 1024 << " KB; with a " << budgetOptions.memoryBudgetMB << " MB budget "
+              << found.size() << " patterns, " << spilledTables << " tables spilled"
+              << (ok ? " - ok\n" : " - MISMATCH\n");
+    for (const auto& level : budgeted.levels) {
+        if (level.peakBytesHeld > budgetOptions.memoryBudgetMB * 1024 * 1024) {
+            std::cout << "  level " << level.patternSize << " held " << level.peakBytesHeld / 1024
+                      << " KB while it was generated\n";
+        }
+    }
+    size_t shown = 0;
+    for (const auto& pattern : expected) {
+        if (!found.count(pattern) && shown++ < 5) std::cout << "  missing " << patternName(pattern) << "\n";
+    }
+    for (const auto& pattern : found) {
+        if (!expected.count(pattern) && shown++ < 10) std::cout << "  extra " << patternName(pattern) << "\n";
+    }
+    return ok ? 0 : 1;
+}
+
+// A session built from instances without ordinals (all 0, in shuffled order) finds the
+// patterns of a session that loads the same instances from a CSV file
+int checkInstanceSession() {
+    SyntheticConfig dataConfig;
+    dataConfig.numInstances = 20000;
+    dataConfig.numFeatures = 10;
+    dataConfig.seed = 17;
+    const std::string csvPath = (std::filesystem::temp_directory_path() / "instance_session_check.csv").string();
+    if (!writeSyntheticCsv(dataConfig, csvPath)) {
+        std::cout << "instance session: cannot write " << csvPath << "\n";
+        return 1;
+    }
+    IndexOptions indexOptions;
+    indexOptions.neighborDistance = dataConfig.neighborDistance;
+    const MiningSession fromCsv(csvPath, indexOptions);
+
+    std::vector<SpatialInstance> instances = DataLoader::load_csv(csvPath);
+    std::filesystem::remove(csvPath);
+    std::shuffle(instances.begin(), instances.end(), std::mt19937_64(3));
+    for (auto& instance : instances) instance.ordinal = 0;
+    const MiningSession fromInstances(std::move(instances), indexOptions);
+
+    const double minPrev = 0.2;
+    const MiningResult expectedResult = fromCsv.mine(minPrev);
+    const MiningResult foundResult = fromInstances.mine(minPrev);
+    const std::set<Colocation> expected(expectedResult.patterns.begin(), expectedResult.patterns.end());
+    const std::set<Colocation> found(foundResult.patterns.begin(), foundResult.patterns.end());
+    const bool ok = !expected.empty() && found == expected;
+    std::cout << "instance session: " << expected.size() << " patterns from the CSV file, " << found.size()
+              << " from instances without ordinals" << (ok ? " - ok\n" : " - MISMATCH\n");
+    size_t shown = 0;
+    for (const auto& pattern : expected) {
+        if (!found.count(pattern) && shown++ < 5) std::cout << "  missing " << patternName(pattern) << "\n";
+    }
+    for (const auto& pattern : found) {
+        if (!expected.count(pattern) && shown++ < 10) std::cout << "  extra " << patternName(pattern) << "\n";
+    }
+    return ok ? 0 : 1;
+}
+
+// Level-wise, depth-first and budgeted (1 MB) mining of a session find the same patterns;
+// minSize is the size the largest pattern must reach
+bool strategiesAgree(const std::string& name, const MiningSession& session, double minPrev, size_t minSize) {
+    const MiningResult levelWise = session.mine(minPrev);
+    MiningOptions depthFirstOptions;
+    depthFirstOptions.strategy = MiningStrategy::DEPTH_FIRST;
+    const MiningResult depthFirst = session.mine(minPrev, depthFirstOptions);
+    MiningOptions budgetOptions;
+    budgetOptions.memoryBudgetMB = 1;
+    const MiningResult budgeted = session.mine(minPrev, budgetOptions);
+
+    size_t largest = 0;
+    for (const auto& pattern : levelWise.patterns) largest = std::max(largest, pattern.size());
+    size_t spilledTables = 0;
+    for (const auto& level : budgeted.levels) spilledTables += level.spilledTables;
+
+    const std::set<Colocation> expected(levelWise.patterns.begin(), levelWise.patterns.end());
+    bool ok = largest >= minSize;
+    for (const auto* result : { &depthFirst, &budgeted }) {
+        const std::set<Colocation> found(result->patterns.begin(), result->patterns.end());
+        const char* run = (result == &depthFirst) ? "depth-first" : "budgeted";
+        size_t shown = 0;
+        for (const auto& pattern : expected) {
+            if (!found.count(pattern) && shown++ < 5) std::cout << "  " << run << " misses " << patternName(pattern) << "\n";
+        }
+        for (const auto& pattern : found) {
+            if (!expected.count(pattern) && shown++ < 10) std::cout << "  " << run << " adds " << patternName(pattern) << "\n";
+        }
+        ok &= found == expected;
+    }
+    std::cout << name << ": " << session.ranking().size() << " features, " << expected.size()
+              << " patterns up to size " << largest << ", " << spilledTables << " tables spilled under 1 MB"
+              << (ok ? " - ok\n" : " - MISMATCH\n");
+    return ok;
+}
+
+// Patterns wider than the fixed-width row tables (TableInstance<DYNAMIC_ROW_WIDTH>) and
+// more features than the fixed-width pattern masks (DynamicFeatureMask), mined by every
+// engine
+int checkWidePatterns() {
+    bool ok = true;
+
+    // One planted size-10 pattern: levels 9 and 10 have no fixed-width specialization
+    {
+        SyntheticConfig dataConfig;
+        dataConfig.numInstances = 6000;
+        dataConfig.numFeatures = 12;
+        dataConfig.raritySkew = 0.0;
+        dataConfig.patternCount = 1;
+        dataConfig.patternSize = 10;
+        dataConfig.noiseDensity = 0.5;
+        dataConfig.seed = 3;
+        IndexOptions indexOptions;
+        indexOptions.neighborDistance = dataConfig.neighborDistance;
+        const MiningSession session(generateSyntheticInstances(dataConfig), indexOptions);
+        ok &= strategiesAgree("wide rows", session, 0.3, Constants::MAX_FIXED_ROW_WIDTH + 2);
+    }
+
+    // 140 features: pattern masks need more than two 64-bit words
+    {
+        SyntheticConfig dataConfig;
+        dataConfig.numInstances = 30000;
+        dataConfig.numFeatures = 140;
+        dataConfig.raritySkew = 0.0;
+        dataConfig.patternCount = 6;
+        dataConfig.patternSize = 4;
+        dataConfig.noiseDensity = 0.5;
+        dataConfig.seed = 5;
+        IndexOptions indexOptions;
+        indexOptions.neighborDistance = dataConfig.neighborDistance;
+        const MiningSession session(generateSyntheticInstances(dataConfig), indexOptions);
+        ok &= session.ranking().size() > FeatureMask<2>::capacity();
+        ok &= strategiesAgree("many features", session, 0.3, 4);
+    }
+    return ok ? 0 : 1;
+}
+
+// mine() calls of one session on several threads at once: every call finds the patterns
+// of a call run alone, and reports itself as not exclusive (no process-wide resources)
+int checkConcurrentMine() {
+    const auto session = syntheticSession();
+    const double minPrev = 0.2;
+    const MiningResult alone = session->mine(minPrev);
+    const std::set<Colocation> expected(alone.patterns.begin(), alone.patterns.end());
+
+    const size_t threadCount = 4;
+    std::vector<MiningResult> results(threadCount);
+    std::atomic<size_t> ready(0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            // Start together, so the calls overlap
+            ready.fetch_add(1);
+            while (ready.load() < threadCount) std::this_thread::yield();
+            MiningOptions options;
+            options.strategy = (t % 2) ? MiningStrategy::DEPTH_FIRST : MiningStrategy::LEVEL_WISE;
+            results[t] = session->mine(minPrev, options);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    bool ok = alone.exclusive && alone.resources.cpuSeconds > 0;
+    for (size_t t = 0; t < threadCount; ++t) {
+        const MiningResult& result = results[t];
+        const bool samePatterns = std::set<Colocation>(result.patterns.begin(), result.patterns.end()) == expected;
+        const bool wallOnly = !result.exclusive && result.resources.cpuSeconds == 0
+            && result.resources.processPeakRSSMB == 0 && result.resources.wallSeconds > 0;
+        if (!samePatterns) std::cout << "  thread " << t << ": " << result.patterns.size() << " patterns\n";
+        if (!wallOnly) std::cout << "  thread " << t << ": process-wide resources reported for an overlapping call\n";
+        ok &= samePatterns && wallOnly;
+    }
+    std::cout << "concurrent mine: " << expected.size() << " patterns alone (exclusive "
+              << (alone.exclusive ? "yes" : "no") << "), " << threadCount << " overlapping calls"
+              << (ok ? " - ok\n" : " - MISMATCH\n");
+    return ok ? 0 : 1;
+}
+
+}
+
+
+const std::vector<std::string>& checkNames() {
+    static const std::vector<std::string> names = { "quadtree_join", "antimeridian", "spill_budget", "wide_patterns", "instance_session", "concurrent_mine" };
+    return names;
+}
+
+int runCheck(const std::string& name) {
+    if (name == "quadtree_join") return checkQuadtreeJoin();
+    if (name == "antimeridian") return checkAntimeridian();
+    if (name == "spill_budget") return checkSpillBudget();
+    if (name == "wide_patterns") return checkWidePatterns();
+    if (name == "instance_session") return checkInstanceSession();
+    if (name == "concurrent_mine") return checkConcurrentMine();
+    std::cerr << "Unknown check: " << name << "\n";
+    return 2;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file checks.h
+ * @brief Correctness checks of the pipeline (bench --check NAME)
+ *
+ * Every check builds its own input (hand-placed or synthetic instances), so it needs no
+ * data files; CMake registers each of them with CTest.
+ *
+ *   quadtree_join     planar neighbor pairs of clustered, duplicate and sparse points at
+ *                     split thresholds 0, 1, 2 and the default, against a brute-force join
+ *   antimeridian      geodesic neighbor pairs of points straddling ±180°, circling a
+ *                     pole, at high latitude with large thresholds and within metres of
+ *                     the pole, against a brute-force haversine join
+ *   spill_budget      level-wise mining under a memory budget smaller than one level's
+ *                     tables finds the same patterns as without a budget
+ *   wide_patterns     level-wise, depth-first and budgeted mining agree on a planted
+ *                     size-10 pattern (dynamic-width rows) and on 140 features (dynamic
+ *                     pattern masks)
+ *   instance_session  a session built from in-memory instances without ordinals finds
+ *                     the patterns of a session loading the same instances from CSV
+ *   concurrent_mine   overlapping MiningSession::mine calls find the patterns of a
+ *                     call run alone and report wall times only
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+
+/** @brief Names of all checks, in the order CTest runs them */
+const std::vector<std::string>& checkNames();
+
+/**
+ * @brief Run one check, printing what differs
+ * @return 0 if it passed, 1 if it failed, 2 for an unknown check
+ */
+int runCheck(const std::string& name);
@@ -0,0 +1,450 @@
+/**
+ * @file kernel_benchmarks.cpp
+ * @brief Google Benchmark microbenchmarks of the mining hot kernels
+ *
+ * Every kernel runs on its own, on synthetic inputs (bench/synthetic_data.h), so an
+ * optimization of one kernel gets an isolated before/after number:
+ *   - spatial join, neighborhood and tree build: instance count x rarity skew
+ *   - findNeighbors: noise density (neighbor-list size)
+ *   - carried extension sets (S(I ∪ {o}, g) = S(I, g) ∩ Neigh(o, g)) and the
+ *     findExtendedSet recompute fallback: noise density x pattern size
+ *   - participation counting of a packed table and level WPI: table rows / level
+ *     patterns x pattern size
+ *   - one whole mining level (table generation with fused PR counting, materialized
+ *     or count-only): noise density x pattern size
+ *   - generateCandidates / filterCandidates: feature count x pattern size
+ *
+ * Skew and density arguments are given in tenths (10 = 1.0). Datasets are generated
+ * once per parameter combination and shared by all benchmarks using them.
+ *
+ * Usage: microbench [--benchmark_filter=<regex>] [--benchmark_format=json] ...
+ */
+
+#include "synthetic_data.h"
+#include "spatial_index.h"
+#include "neighborhood_mgr.h"
+#include "NRTree.h"
+#include "miner.h"
+#include "feature_ranking.h"
+#include "utils.h"
+#include "table_instance.h"
+#include "level_arena.h"
+#include <benchmark/benchmark.h>
+#include <map>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief One synthetic dataset with every structure built up to the NR-tree
+ */
+struct Dataset {
+    std::vector<SpatialInstance> instances;
+    FeatureRanking ranking;
+    std::vector<std::pair<SpatialInstance, SpatialInstance>> pairs;
+    NeighborhoodMgr neighborMgr;
+    NRTree tree;
+    bool treeBuilt = false;
+};
+
+const double NEIGHBOR_DISTANCE = 100.0;
+
+SyntheticConfig datasetConfig(size_t numInstances, double skew, double density) {
+    SyntheticConfig config;
+    config.numInstances = numInstances;
+    config.numFeatures = 15;
+    config.raritySkew = skew;
+    config.noiseDensity = density;
+    config.neighborDistance = NEIGHBOR_DISTANCE;
+    return config;
+}
+
+// Dataset of the given parameters, built on first use (skew and density in tenths).
+// Neighborhoods and the tree are only built for benchmarks that need them.
+const Dataset& dataset(size_t numInstances, int64_t skewTenths, int64_t densityTenths, bool withTree = true) {
+    static std::map<std::tuple<size_t, int64_t, int64_t>, std::unique_ptr<Dataset>> cache;
+    auto& entry = cache[std::make_tuple(numInstances, skewTenths, densityTenths)];
+    if (!entry) {
+        entry = std::make_unique<Dataset>();
+        entry->instances = generateSyntheticInstances(datasetConfig(numInstances, skewTenths / 10.0, densityTenths / 10.0));
+        entry->ranking = FeatureRanking(entry->instances);
+        entry->pairs = SpatialIndex(NEIGHBOR_DISTANCE).findNeighborPair(entry->instances);
+    }
+    if (withTree && !entry->treeBuilt) {
+        entry->neighborMgr.buildFromPairs(entry->pairs, entry->ranking);
+        entry->tree.build(entry->neighborMgr, entry->ranking);
+        entry->treeBuilt = true;
+    }
+    return *entry;
+}
+
+// Feature-ordered star of an instance: (feature, neighbors) for every later feature it has neighbors of
+std::vector<std::pair<FeatureType, std::vector<const SpatialInstance*>>> starOf(
+    JoinlessMiner& miner, const Dataset& data, const SpatialInstance* center) {
+    std::vector<std::pair<FeatureType, std::vector<const SpatialInstance*>>> star;
+    const std::vector<FeatureType>& features = data.ranking.features();
+    for (size_t r = data.ranking.rank(center->type) + 1; r < features.size(); ++r) {
+        auto neighbors = miner.findNeighbors(data.tree, center, features[r]);
+        if (!neighbors.empty()) star.emplace_back(features[r], std::move(neighbors));
+    }
+    return star;
+}
+
+// Rows of rowSize instances taken from stars (center + one neighbor of each of the next
+// features), each with the feature after the last one in the star
+std::vector<std::pair<ColocationInstance, FeatureType>> starRows(
+    JoinlessMiner& miner, const Dataset& data, size_t rowSize, size_t maxRows) {
+    std::vector<std::pair<ColocationInstance, FeatureType>> rows;
+    for (size_t i = 0; i < data.instances.size() && rows.size() < maxRows; ++i) {
+        const auto star = starOf(miner, data, &data.instances[i]);
+        if (star.size() < rowSize) continue;
+        ColocationInstance row = { &data.instances[i] };
+        for (size_t s = 0; s + 1 < rowSize; ++s) row.push_back(star[s].second.front());
+        rows.emplace_back(std::move(row), star[rowSize - 1].first);
+    }
+    return rows;
+}
+
+// Ranking of `count` features F0.. with Zipf-distributed instance counts
+FeatureRanking zipfRanking(size_t count) {
+    std::map<FeatureType, int> counts;
+    for (size_t f = 0; f < count; ++f) {
+        counts["F" + std::to_string(f)] = static_cast<int>(100000 / (f + 1));
+    }
+    return FeatureRanking(counts);
+}
+
+// Every size-k pattern over the ranked features, in lexicographic (rank) order
+std::vector<Colocation> allPatterns(const FeatureRanking& ranking, size_t k) {
+    std::vector<Colocation> patterns;
+    const std::vector<FeatureType>& features = ranking.features();
+    std::vector<size_t> index(k);
+    for (size_t i = 0; i < k; ++i) index[i] = i;
+    while (k <= features.size()) {
+        Colocation pattern;
+        for (const size_t i : index) pattern.push_back(features[i]);
+        patterns.push_back(std::move(pattern));
+
+        // Next combination
+        size_t pos = k;
+        while (pos > 0 && index[pos - 1] == features.size() - k + pos - 1) --pos;
+        if (pos == 0) break;
+        ++index[pos - 1];
+        for (size_t i = pos; i < k; ++i) index[i] = index[i - 1] + 1;
+    }
+    return patterns;
+}
+
+}
+
+
+// ============================================================================
+// Neighborhood materialization
+// ============================================================================
+
+static void BM_FindNeighborPair(benchmark::State& state) {
+    const Dataset& data = dataset(static_cast<size_t>(state.range(0)), state.range(1), 20, false);
+    const SpatialIndex index(NEIGHBOR_DISTANCE);
+    for (auto _ : state) {
+        auto pairs = index.findNeighborPair(data.instances);
+        benchmark::DoNotOptimize(pairs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * data.instances.size());
+    state.counters["pairs"] = static_cast<double>(data.pairs.size());
+}
+BENCHMARK(BM_FindNeighborPair)
+    ->ArgNames({ "instances", "skew" })
+    ->ArgsProduct({ { 10000, 100000 }, { 0, 10, 20 } })
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_BuildFromPairs(benchmark::State& state) {
+    const Dataset& data = dataset(static_cast<size_t>(state.range(0)), state.range(1), 20, false);
+    for (auto _ : state) {
+        NeighborhoodMgr neighborMgr;
+        neighborMgr.buildFromPairs(data.pairs, data.ranking);
+        benchmark::DoNotOptimize(neighborMgr);
+    }
+    state.SetItemsProcessed(state.iterations() * data.pairs.size());
+}
+BENCHMARK(BM_BuildFromPairs)
+    ->ArgNames({ "instances", "skew" })
+    ->ArgsProduct({ { 5000, 20000 }, { 0, 10, 20 } })
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_NRTreeBuild(benchmark::State& state) {
+    const Dataset& data = dataset(static_cast<size_t>(state.range(0)), state.range(1), 20);
+    for (auto _ : state) {
+        NRTree tree;
+        tree.build(data.neighborMgr, data.ranking);
+        benchmark::DoNotOptimize(tree.getRoot());
+    }
+    state.SetItemsProcessed(state.iterations() * data.pairs.size());
+}
+BENCHMARK(BM_NRTreeBuild)
+    ->ArgNames({ "instances", "skew" })
+    ->ArgsProduct({ { 5000, 20000 }, { 0, 10, 20 } })
+    ->Unit(benchmark::kMillisecond);
+
+
+// ============================================================================
+// NR-tree lookups
+// ============================================================================
+
+static void BM_FindNeighbors(benchmark::State& state) {
+    const Dataset& data = dataset(10000, 10, state.range(0));
+    JoinlessMiner miner;
+
+    // Lookups of every later feature from the first instances
+    std::vector<std::pair<const SpatialInstance*, FeatureType>> queries;
+    const std::vector<FeatureType>& features = data.ranking.features();
+    for (size_t i = 0; i < data.instances.size() && queries.size() < 20000; i += 7) {
+        const SpatialInstance* center = &data.instances[i];
+        for (size_t r = data.ranking.rank(center->type) + 1; r < features.size(); ++r) {
+            queries.emplace_back(center, features[r]);
+        }
+    }
+
+    size_t listEntries = 0;
+    for (auto _ : state) {
+        listEntries = 0;
+        for (const auto& query : queries) {
+            const auto neighbors = miner.findNeighbors(data.tree, query.first, query.second);
+            listEntries += neighbors.size();
+        }
+        benchmark::DoNotOptimize(listEntries);
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+    state.counters["avg_list"] = static_cast<double>(listEntries) / std::max<size_t>(queries.size(), 1);
+}
+BENCHMARK(BM_FindNeighbors)
+    ->ArgNames({ "density" })
+    ->Arg(5)->Arg(20)->Arg(80)->Arg(320)
+    ->Unit(benchmark::kMicrosecond);
+
+// Extension sets carried with the rows (the hot path since extension sets are kept
+// across levels): the set of a new row is S(I, g) ∩ Neigh(o, g), written into a level arena
+static void BM_IntersectCarriedSet(benchmark::State& state) {
+    const size_t rowSize = static_cast<size_t>(state.range(0)) - 1;
+    const Dataset& data = dataset(10000, 10, state.range(1));
+    JoinlessMiner miner;
+
+    // S(I, g) of the row without its last instance o, computed once; Neigh(o, g) of o
+    std::vector<std::vector<const SpatialInstance*>> carried;
+    std::vector<std::vector<const SpatialInstance*>> neighbors;
+    for (const auto& row : starRows(miner, data, rowSize, 5000)) {
+        const ColocationInstance prefix(row.first.begin(), row.first.end() - 1);
+        carried.push_back(miner.findExtendedSet(data.tree, prefix, row.second));
+        neighbors.push_back(miner.findNeighbors(data.tree, row.first.back(), row.second));
+    }
+
+    size_t extensions = 0;
+    for (auto _ : state) {
+        LevelArena arena;
+        std::pmr::memory_resource* resource = arena.local();
+        extensions = 0;
+        for (size_t r = 0; r < carried.size(); ++r) {
+            ExtensionTable::InstanceSet out(resource);
+            intersectByOrdinal(carried[r], neighbors[r], out);
+            extensions += out.size();
+        }
+        benchmark::DoNotOptimize(extensions);
+    }
+    state.SetItemsProcessed(state.iterations() * carried.size());
+    state.counters["avg_set"] = static_cast<double>(extensions) / std::max<size_t>(carried.size(), 1);
+}
+BENCHMARK(BM_IntersectCarriedSet)
+    ->ArgNames({ "k", "density" })
+    ->ArgsProduct({ { 3, 4, 5 }, { 20, 80, 320 } })
+    ->Unit(benchmark::kMicrosecond);
+
+// Recompute fallback only: the miner calls findExtendedSet for rows whose S(I, f) was not
+// carried (tables read back from disk, or generated after the level started spilling)
+static void BM_FindExtendedSetFallback(benchmark::State& state) {
+    const size_t rowSize = static_cast<size_t>(state.range(0)) - 1;
+    const Dataset& data = dataset(10000, 10, state.range(1));
+    JoinlessMiner miner;
+    const auto rows = starRows(miner, data, rowSize, 5000);
+
+    size_t extensions = 0;
+    for (auto _ : state) {
+        extensions = 0;
+        for (const auto& row : rows) {
+            extensions += miner.findExtendedSet(data.tree, row.first, row.second).size();
+        }
+        benchmark::DoNotOptimize(extensions);
+    }
+    state.SetItemsProcessed(state.iterations() * rows.size());
+    state.counters["avg_set"] = static_cast<double>(extensions) / std::max<size_t>(rows.size(), 1);
+}
+BENCHMARK(BM_FindExtendedSetFallback)
+    ->ArgNames({ "k", "density" })
+    ->ArgsProduct({ { 2, 3, 4, 5 }, { 20, 80, 320 } })
+    ->Unit(benchmark::kMicrosecond);
+
+
+// ============================================================================
+// Prevalence and candidates
+// ============================================================================
+
+// Participation of one packed table: every row marks its ordinals in per-position
+// instance bitmaps, and the marked counts give the PRs (as while rows are generated)
+static void BM_CountParticipation(benchmark::State& state) {
+    const size_t rows = static_cast<size_t>(state.range(0));
+    const size_t patternSize = static_cast<size_t>(state.range(1));
+    const Dataset& data = dataset(100000, 10, 20, false);
+    const Colocation pattern(data.ranking.features().begin(), data.ranking.features().begin() + patternSize);
+    std::vector<uint32_t> counts;
+    for (const auto& feature : pattern) counts.push_back(static_cast<uint32_t>(data.ranking.count(feature)));
+
+    // Table of random rows (ordinals of each position's feature)
+    std::mt19937_64 rng(7);
+    PackedTable table(patternSize);
+    table.reserve(rows);
+    std::vector<uint32_t> row(patternSize);
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t i = 0; i < patternSize; ++i) row[i] = static_cast<uint32_t>(rng() % counts[i]);
+        table.push_back(row.data());
+    }
+
+    for (auto _ : state) {
+        std::vector<InstanceBitmap> participants;
+        for (const uint32_t count : counts) participants.emplace_back(count);
+        for (size_t r = 0; r < table.size(); ++r) {
+            const uint32_t* ordinals = table.row(r);
+            for (size_t i = 0; i < patternSize; ++i) participants[i].set(ordinals[i]);
+        }
+        double pi = 1.0;
+        for (size_t i = 0; i < patternSize; ++i) {
+            pi = std::min(pi, static_cast<double>(participants[i].count()) / counts[i]);
+        }
+        benchmark::DoNotOptimize(pi);
+    }
+    state.SetItemsProcessed(state.iterations() * rows * patternSize);
+}
+BENCHMARK(BM_CountParticipation)
+    ->ArgNames({ "rows", "k" })
+    ->ArgsProduct({ { 1000, 10000, 100000 }, { 2, 3, 4 } })
+    ->Unit(benchmark::kMicrosecond);
+
+// WPI of a whole level from its PRs through the precomputed weight table
+static void BM_LevelWPI(benchmark::State& state) {
+    const FeatureRanking ranking = zipfRanking(static_cast<size_t>(state.range(0)));
+    const size_t k = static_cast<size_t>(state.range(1));
+    const RareWeightTable weights(ranking.features(), ranking.counts(),
+        calculateDelta(ranking.features(), ranking.counts()));
+
+    std::mt19937_64 rng(13);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<uint32_t> ranks;
+    std::vector<double> prs;
+    for (const auto& pattern : allPatterns(ranking, k)) {
+        for (const auto& feature : pattern) {
+            ranks.push_back(static_cast<uint32_t>(ranking.rank(feature)));
+            prs.push_back(unit(rng));
+        }
+    }
+
+    std::vector<double> wpi;
+    for (auto _ : state) {
+        weights.levelWPI(ranks, prs, k, wpi);
+        benchmark::DoNotOptimize(wpi.data());
+    }
+    state.SetItemsProcessed(state.iterations() * (ranks.size() / k));
+}
+BENCHMARK(BM_LevelWPI)
+    ->ArgNames({ "features", "k" })
+    ->ArgsProduct({ { 10, 20, 30 }, { 2, 3, 4 } })
+    ->Unit(benchmark::kMicrosecond);
+
+// One level of a real run: candidates, pruning, table generation with the fused PR
+// counting and prevalence selection. Only the level itself is timed (its wall time from
+// the level statistics); the earlier levels of every iteration are not. Count-only levels
+// are the last allowed level (no rows kept), materialized ones keep rows for level k + 1
+static void BM_MineLevel(benchmark::State& state) {
+    const size_t k = static_cast<size_t>(state.range(0));
+    const bool countOnly = state.range(1) != 0;
+    const Dataset& data = dataset(10000, 10, state.range(2));
+    MiningOptions options;
+    options.maxPatternSize = countOnly ? k : k + 1;
+
+    size_t tableRows = 0, filtered = 0;
+    for (auto _ : state) {
+        JoinlessMiner miner;
+        const auto patterns = miner.mineColocations(0.1, data.tree, data.ranking, options);
+        benchmark::DoNotOptimize(patterns.data());
+        if (miner.levelStats().size() < k - 1) {
+            state.SkipWithError("level not reached");
+            break;
+        }
+        const LevelStats& level = miner.levelStats()[k - 2];
+        state.SetIterationTime(level.resources.wallSeconds);
+        tableRows = level.tableRows;
+        filtered = level.filtered;
+    }
+    state.counters["candidates"] = static_cast<double>(filtered);
+    state.counters["rows"] = static_cast<double>(tableRows);
+}
+BENCHMARK(BM_MineLevel)
+    ->ArgNames({ "k", "count_only", "density" })
+    ->ArgsProduct({ { 2, 3, 4 }, { 0, 1 }, { 20, 80 } })
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_GenerateCandidates(benchmark::State& state) {
+    const FeatureRanking ranking = zipfRanking(static_cast<size_t>(state.range(0)));
+    const std::vector<Colocation> prevPrevalent = allPatterns(ranking, static_cast<size_t>(state.range(1)) - 1);
+    JoinlessMiner miner;
+
+    size_t generated = 0;
+    for (auto _ : state) {
+        const auto candidates = miner.generateCandidates(prevPrevalent, ranking);
+        generated = candidates.size();
+        benchmark::DoNotOptimize(candidates.data());
+    }
+    state.SetItemsProcessed(state.iterations() * prevPrevalent.size());
+    state.counters["candidates"] = static_cast<double>(generated);
+}
+BENCHMARK(BM_GenerateCandidates)
+    ->ArgNames({ "features", "k" })
+    ->ArgsProduct({ { 10, 20, 30 }, { 3, 4, 5 } })
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_FilterCandidates(benchmark::State& state) {
+    const FeatureRanking ranking = zipfRanking(static_cast<size_t>(state.range(0)));
+    const size_t k = static_cast<size_t>(state.range(1));
+    const double minPrev = 0.3;
+    JoinlessMiner miner;
+
+    // Previous level: every (k-1)-pattern, about 80% of them prevalent
+    std::mt19937_64 rng(11);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    PatternMetricsStore prevMetrics;
+    for (const auto& pattern : allPatterns(ranking, k - 1)) {
+        PatternMetrics metrics;
+        metrics.participationIndex = unit(rng);
+        metrics.weightedParticipationIndex = metrics.participationIndex;
+        metrics.prevalent = unit(rng) < 0.8;
+        prevMetrics.add(pattern, std::move(metrics));
+    }
+    const std::vector<Colocation> candidates = miner.generateCandidates(prevMetrics.patterns(), ranking);
+    const double delta = calculateDelta(ranking.features(), ranking.counts());
+
+    size_t kept = 0;
+    for (auto _ : state) {
+        const auto filtered = miner.filterCandidates(candidates, prevMetrics, minPrev, ranking, delta);
+        kept = filtered.size();
+        benchmark::DoNotOptimize(filtered.data());
+    }
+    state.SetItemsProcessed(state.iterations() * candidates.size());
+    state.counters["kept"] = static_cast<double>(kept);
+}
+BENCHMARK(BM_FilterCandidates)
+    ->ArgNames({ "features", "k" })
+    ->ArgsProduct({ { 10, 20, 30 }, { 3, 4, 5 } })
+    ->Unit(benchmark::kMicrosecond);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,380 @@
+/**
+ * @file perfcheck.cpp
+ * @brief Implementation of the performance regression gate
+ */
+
+#include "perfcheck.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+// ============================================================================
+// Minimal JSON reader (baseline and run reports are written by this project)
+// ============================================================================
+
+struct JsonValue {
+    enum class Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT } type = Type::NUL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    const JsonValue* get(const std::string& key) const {
+        for (const auto& member : members) {
+            if (member.first == key) return &member.second;
+        }
+        return nullptr;
+    }
+
+    double numberAt(const std::string& key, double fallback) const {
+        const JsonValue* value = get(key);
+        return (value && value->type == Type::NUMBER) ? value->number : fallback;
+    }
+
+    std::string textAt(const std::string& key) const {
+        const JsonValue* value = get(key);
+        return (value && value->type == Type::STRING) ? value->text : std::string();
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : text(text) {}
+
+    bool parse(JsonValue& value) {
+        return parseValue(value) && (skipSpace(), pos == text.size());
+    }
+
+private:
+    const std::string& text;
+    size_t pos = 0;
+
+    void skipSpace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (pos < text.size() && text[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseString(std::string& out) {
+        if (!consume('"')) return false;
+        out.clear();
+        while (pos < text.size() && text[pos] != '"') {
+            if (text[pos] == '\\' && pos + 1 < text.size()) ++pos;
+            out += text[pos++];
+        }
+        return pos < text.size() && text[pos++] == '"';
+    }
+
+    bool parseValue(JsonValue& value) {
+        skipSpace();
+        if (pos >= text.size()) return false;
+        const char c = text[pos];
+
+        if (c == '{') {
+            ++pos;
+            value.type = JsonValue::Type::OBJECT;
+            if (consume('}')) return true;
+            do {
+                std::pair<std::string, JsonValue> member;
+                if (!parseString(member.first) || !consume(':') || !parseValue(member.second)) return false;
+                value.members.push_back(std::move(member));
+            } while (consume(','));
+            return consume('}');
+        }
+        if (c == '[') {
+            ++pos;
+            value.type = JsonValue::Type::ARRAY;
+            if (consume(']')) return true;
+            do {
+                JsonValue item;
+                if (!parseValue(item)) return false;
+                value.items.push_back(std::move(item));
+            } while (consume(','));
+            return consume(']');
+        }
+        if (c == '"') {
+            value.type = JsonValue::Type::STRING;
+            return parseString(value.text);
+        }
+        for (const char* literal : { "true", "false", "null" }) {
+            const std::string word(literal);
+            if (text.compare(pos, word.size(), word) == 0) {
+                pos += word.size();
+                value.type = (word == "null") ? JsonValue::Type::NUL : JsonValue::Type::BOOLEAN;
+                value.boolean = (word == "true");
+                return true;
+            }
+        }
+
+        const char* start = text.c_str() + pos;
+        char* end = nullptr;
+        value.type = JsonValue::Type::NUMBER;
+        value.number = std::strtod(start, &end);
+        if (end == start) return false;
+        pos += static_cast<size_t>(end - start);
+        return true;
+    }
+};
+
+bool readJsonFile(const std::string& path, JsonValue& value) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string text = buffer.str();
+    return JsonParser(text).parse(value);
+}
+
+// ============================================================================
+// Datasets and measurements
+// ============================================================================
+
+/** @brief Metrics compared against the baseline, in report order */
+const char* METRICS[] = { "wall_s", "mining_s", "peak_rss_mb" };
+constexpr size_t METRIC_COUNT = 3;
+
+struct PerfCase {
+    std::string name;
+    std::string dataset;
+    double neighborDistance = 0.0;
+    double minPrevalence = 0.0;
+    double patterns = -1.0;                     ///< Expected pattern count (-1 = unknown)
+    RobustStats baseline[METRIC_COUNT] = {};
+    bool hasBaseline = false;
+};
+
+struct PerfBaseline {
+    int runs = 5;
+    double timeTolerance = 0.25;   ///< Allowed relative slowdown of the median
+    double memoryTolerance = 0.15; ///< Allowed relative growth of the median peak RSS
+    double timeFloorSeconds = 0.05; ///< Slowdowns smaller than this are never regressions
+    double memoryFloorMB = 5.0;     ///< Peak RSS growth smaller than this is never a regression
+    std::vector<PerfCase> cases;
+};
+
+// Bundled datasets, used when no baseline file exists yet
+PerfBaseline defaultBaseline() {
+    PerfBaseline baseline;
+    baseline.cases = {
+        { "sample", "data/sample_data.csv", 3.5, 0.3 },
+        { "5k_15f_50k", "data/5k_15f_50k.csv", 30.0, 0.3 },
+        { "las_vegas", "data/LasVegas_x_y_alphabet_version_03_2.csv", 160.0, 0.15 },
+    };
+    return baseline;
+}
+
+bool loadBaseline(const std::string& path, PerfBaseline& baseline) {
+    JsonValue root;
+    if (!readJsonFile(path, root) || root.type != JsonValue::Type::OBJECT) return false;
+
+    baseline.runs = static_cast<int>(root.numberAt("runs", baseline.runs));
+    baseline.timeTolerance = root.numberAt("time_tolerance", baseline.timeTolerance);
+    baseline.memoryTolerance = root.numberAt("memory_tolerance", baseline.memoryTolerance);
+    baseline.timeFloorSeconds = root.numberAt("time_floor_s", baseline.timeFloorSeconds);
+    baseline.memoryFloorMB = root.numberAt("memory_floor_mb", baseline.memoryFloorMB);
+
+    const JsonValue* datasets = root.get("datasets");
+    if (!datasets || datasets->type != JsonValue::Type::ARRAY) return false;
+    baseline.cases.clear();
+    for (const JsonValue& entry : datasets->items) {
+        PerfCase perfCase;
+        perfCase.name = entry.textAt("name");
+        perfCase.dataset = entry.textAt("dataset");
+        perfCase.neighborDistance = entry.numberAt("neighbor_distance", 0.0);
+        perfCase.minPrevalence = entry.numberAt("min_prevalence", 0.0);
+        perfCase.patterns = entry.numberAt("patterns", -1.0);
+        perfCase.hasBaseline = true;
+        for (size_t m = 0; m < METRIC_COUNT; ++m) {
+            const JsonValue* stats = entry.get(METRICS[m]);
+            if (!stats) {
+                perfCase.hasBaseline = false;
+                continue;
+            }
+            perfCase.baseline[m].median = stats->numberAt("median", 0.0);
+            perfCase.baseline[m].mad = stats->numberAt("mad", 0.0);
+        }
+        baseline.cases.push_back(std::move(perfCase));
+    }
+    return true;
+}
+
+bool writeBaseline(const std::string& path, const PerfBaseline& baseline) {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+
+    out << std::setprecision(6);
+    out << "{\n";
+    out << "  \"runs\": " << baseline.runs << ",\n";
+    out << "  \"time_tolerance\": " << baseline.timeTolerance << ",\n";
+    out << "  \"memory_tolerance\": " << baseline.memoryTolerance << ",\n";
+    out << "  \"time_floor_s\": " << baseline.timeFloorSeconds << ",\n";
+    out << "  \"memory_floor_mb\": " << baseline.memoryFloorMB << ",\n";
+    out << "  \"datasets\": [\n";
+    for (size_t c = 0; c < baseline.cases.size(); ++c) {
+        const PerfCase& perfCase = baseline.cases[c];
+        out << "    { \"name\": \"" << perfCase.name << "\", \"dataset\": \"" << perfCase.dataset << "\""
+            << ", \"neighbor_distance\": " << perfCase.neighborDistance
+            << ", \"min_prevalence\": " << perfCase.minPrevalence
+            << ", \"patterns\": " << perfCase.patterns;
+        for (size_t m = 0; m < METRIC_COUNT; ++m) {
+            out << ",\n      \"" << METRICS[m] << "\": { \"median\": " << perfCase.baseline[m].median
+                << ", \"mad\": " << perfCase.baseline[m].mad << " }";
+        }
+        out << " }" << (c + 1 < baseline.cases.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+struct RunResult {
+    double metrics[METRIC_COUNT] = { 0.0, 0.0, 0.0 };
+    double patterns = 0.0;
+};
+
+// One run of the main executable on a dataset; false if it failed or wrote no report
+bool runOnce(const std::string& mainPath, const PerfCase& perfCase, RunResult& result) {
+    const std::filesystem::path tempDir = std::filesystem::temp_directory_path();
+    const std::string configPath = (tempDir / "perfcheck_config.txt").string();
+    const std::string reportPath = (tempDir / "perfcheck_report.json").string();
+    std::filesystem::remove(reportPath);
+
+    {
+        std::ofstream config(configPath);
+        config << "dataset_path=" << perfCase.dataset << "\n"
+            << "neighbor_distance=" << perfCase.neighborDistance << "\n"
+            << "min_prevalence=" << perfCase.minPrevalence << "\n"
+            << "report_path=" << reportPath << "\n"
+            << "memory_sample_ms=0\n"
+            << "debug_mode=false\n";
+    }
+
+#if defined(_WIN32)
+    const std::string command = "\"\"" + mainPath + "\" \"" + configPath + "\" > NUL\"";
+#else
+    const std::string command = "\"" + mainPath + "\" \"" + configPath + "\" > /dev/null";
+#endif
+    if (std::system(command.c_str()) != 0) return false;
+
+    JsonValue report;
+    if (!readJsonFile(reportPath, report)) return false;
+    result.metrics[0] = report.numberAt("wall_s", 0.0);
+    result.metrics[2] = report.numberAt("peak_rss_mb", 0.0);
+    result.patterns = report.numberAt("patterns_found", 0.0);
+    if (const JsonValue* stages = report.get("stages")) {
+        for (const JsonValue& stage : stages->items) {
+            if (stage.textAt("name") == "mining") result.metrics[1] = stage.numberAt("wall_s", 0.0);
+        }
+    }
+    return true;
+}
+
+}
+
+
+RobustStats robustStats(std::vector<double> values) {
+    RobustStats stats;
+    if (values.empty()) return stats;
+
+    auto median = [](std::vector<double>& sample) {
+        std::sort(sample.begin(), sample.end());
+        const size_t mid = sample.size() / 2;
+        return (sample.size() % 2) ? sample[mid] : (sample[mid - 1] + sample[mid]) / 2.0;
+    };
+    stats.median = median(values);
+    for (double& value : values) value = std::fabs(value - stats.median);
+    stats.mad = median(values);
+    return stats;
+}
+
+
+int runPerfCheck(const PerfCheckOptions& options) {
+    PerfBaseline baseline = defaultBaseline();
+    if (!loadBaseline(options.baselinePath, baseline)) {
+        if (!options.update) {
+            std::cerr << "Cannot read the baseline " << options.baselinePath << " (run with --update to create it).\n";
+            return 2;
+        }
+        std::cout << "No baseline at " << options.baselinePath << ", measuring the bundled datasets.\n";
+    }
+    const int runs = (options.runs > 0) ? options.runs : baseline.runs;
+
+    bool failed = false;
+    for (PerfCase& perfCase : baseline.cases) {
+        // One unmeasured run warms the file cache
+        RunResult warmup;
+        if (!runOnce(options.mainPath, perfCase, warmup)) {
+            std::cerr << perfCase.name << ": run of " << options.mainPath << " failed.\n";
+            return 2;
+        }
+
+        std::vector<double> samples[METRIC_COUNT];
+        double patterns = warmup.patterns;
+        for (int r = 0; r < runs; ++r) {
+            RunResult result;
+            if (!runOnce(options.mainPath, perfCase, result)) {
+                std::cerr << perfCase.name << ": run of " << options.mainPath << " failed.\n";
+                return 2;
+            }
+            for (size_t m = 0; m < METRIC_COUNT; ++m) samples[m].push_back(result.metrics[m]);
+            patterns = result.patterns;
+        }
+
+        RobustStats current[METRIC_COUNT];
+        for (size_t m = 0; m < METRIC_COUNT; ++m) current[m] = robustStats(samples[m]);
+
+        std::cout << perfCase.name << " (" << runs << " runs, " << patterns << " patterns)\n";
+        if (perfCase.patterns >= 0.0 && patterns != perfCase.patterns) {
+            std::cout << "  RESULT MISMATCH: " << patterns << " patterns, baseline " << perfCase.patterns << "\n";
+            failed = !options.update;
+        }
+        for (size_t m = 0; m < METRIC_COUNT; ++m) {
+            std::cout << "  " << std::left << std::setw(12) << METRICS[m] << std::right << std::fixed
+                << std::setprecision(3) << current[m].median << " (MAD " << current[m].mad << ")";
+            if (perfCase.hasBaseline) {
+                const RobustStats& base = perfCase.baseline[m];
+                const bool memory = (m == METRIC_COUNT - 1);
+                const double tolerance = memory ? baseline.memoryTolerance : baseline.timeTolerance;
+                const double floor = memory ? baseline.memoryFloorMB : baseline.timeFloorSeconds;
+                const double limit = base.median * (1.0 + tolerance) + 3.0 * base.mad;
+                const bool regressed = current[m].median > limit && current[m].median - base.median > floor;
+                std::cout << "  baseline " << base.median << ", limit " << limit << (regressed ? "  REGRESSION" : "");
+                failed = failed || (regressed && !options.update);
+            }
+            std::cout << std::defaultfloat << "\n";
+        }
+
+        if (options.update) {
+            for (size_t m = 0; m < METRIC_COUNT; ++m) perfCase.baseline[m] = current[m];
+            perfCase.patterns = patterns;
+            perfCase.hasBaseline = true;
+        }
+    }
+
+    if (options.update) {
+        if (!writeBaseline(options.baselinePath, baseline)) {
+            std::cerr << "Cannot write the baseline " << options.baselinePath << ".\n";
+            return 2;
+        }
+        std::cout << "Baseline written to " << options.baselinePath << "\n";
+        return 0;
+    }
+    std::cout << (failed ? "perfcheck FAILED\n" : "perfcheck passed\n");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file perfcheck.h
+ * @brief Performance regression gate against a checked-in baseline
+ *
+ * Runs the bundled datasets several times through the main executable (one process per
+ * run, so every run has its own peak RSS) and reads the JSON run report of each run.
+ * Wall time, mining time and peak RSS are summarized by median and MAD and compared
+ * with bench/perf_baseline.json:
+ *
+ *   regression if median > baseline median * (1 + tolerance) + 3 * baseline MAD
+ *
+ * A different pattern count than the baseline's is reported as a result mismatch.
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * @brief Median and median absolute deviation of a sample
+ */
+struct RobustStats {
+    double median = 0.0;
+    double mad = 0.0;
+};
+
+RobustStats robustStats(std::vector<double> values);
+
+/**
+ * @brief Options of a perfcheck run
+ */
+struct PerfCheckOptions {
+    std::string baselinePath = "../bench/perf_baseline.json"; ///< Baseline JSON (relative to the build directory)
+    std::string mainPath;                                     ///< Main executable to measure
+    int runs = 0;                                             ///< Measured runs per dataset (0 = baseline's)
+    bool update = false;                                      ///< Rewrite the baseline with the measured values
+};
+
+/**
+ * @brief Run the regression gate
+ * @return 0 if no dataset regressed, 1 on a regression or result mismatch, 2 on errors
+ */
+int runPerfCheck(const PerfCheckOptions& options);
@@ -0,0 +1,122 @@
+/**
+ * @file synthetic_data.cpp
+ * @brief Implementation of the synthetic dataset generator
+ */
+
+#include "synthetic_data.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <random>
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+// Zipf-distributed instance counts summing to numInstances, every feature at least 1
+std::vector<size_t> featureCounts(const SyntheticConfig& config) {
+    std::vector<double> weights(config.numFeatures);
+    for (size_t f = 0; f < weights.size(); ++f) {
+        weights[f] = 1.0 / std::pow(static_cast<double>(f + 1), config.raritySkew);
+    }
+    const double totalWeight = std::accumulate(weights.begin(), weights.end(), 0.0);
+
+    std::vector<size_t> counts(config.numFeatures);
+    for (size_t f = 0; f < counts.size(); ++f) {
+        counts[f] = std::max<size_t>(1, static_cast<size_t>(std::llround(config.numInstances * weights[f] / totalWeight)));
+    }
+    return counts;
+}
+
+std::string featureName(size_t index) {
+    return "F" + std::to_string(index);
+}
+
+}
+
+
+double generateSynthetic(
+    const SyntheticConfig& config,
+    const std::function<void(const FeatureType&, uint32_t, double, double)>& emit
+) {
+    std::mt19937_64 rng(config.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    const std::vector<size_t> counts = featureCounts(config);
+    const double side = config.neighborDistance *
+        std::sqrt(static_cast<double>(config.numInstances) / std::max(config.noiseDensity, 1e-9));
+
+    // Planted patterns: random feature subsets; clusters take instances from the budgets
+    std::vector<size_t> remaining = counts;
+    std::vector<std::vector<std::pair<double, double>>> planted(config.numFeatures);
+    const size_t patternSize = std::min(config.patternSize, config.numFeatures);
+    std::vector<size_t> allFeatures(config.numFeatures);
+    std::iota(allFeatures.begin(), allFeatures.end(), 0);
+    const double radius = config.clusterSpread * config.neighborDistance / 2.0;
+
+    for (size_t p = 0; p < config.patternCount && patternSize >= 2; ++p) {
+        std::shuffle(allFeatures.begin(), allFeatures.end(), rng);
+        const std::vector<size_t> pattern(allFeatures.begin(), allFeatures.begin() + patternSize);
+
+        size_t rarest = SIZE_MAX;
+        for (const size_t f : pattern) rarest = std::min(rarest, counts[f]);
+        size_t clusters = static_cast<size_t>(config.patternPrevalence * rarest);
+        for (const size_t f : pattern) clusters = std::min(clusters, remaining[f]);
+
+        for (size_t c = 0; c < clusters; ++c) {
+            const double cx = unit(rng) * side;
+            const double cy = unit(rng) * side;
+            for (const size_t f : pattern) {
+                // Uniform in the disc of the cluster
+                const double r = radius * std::sqrt(unit(rng));
+                const double angle = 2.0 * PI * unit(rng);
+                planted[f].push_back({ cx + r * std::cos(angle), cy + r * std::sin(angle) });
+                --remaining[f];
+            }
+        }
+    }
+
+    // Emit planted instances first, then the uniform noise of the feature
+    for (size_t f = 0; f < config.numFeatures; ++f) {
+        const FeatureType name = featureName(f);
+        uint32_t number = 1;
+        for (const auto& point : planted[f]) emit(name, number++, point.first, point.second);
+        std::vector<std::pair<double, double>>().swap(planted[f]);
+        for (size_t i = 0; i < remaining[f]; ++i) {
+            const double x = unit(rng) * side;
+            const double y = unit(rng) * side;
+            emit(name, number++, x, y);
+        }
+    }
+    return side;
+}
+
+
+std::vector<SpatialInstance> generateSyntheticInstances(const SyntheticConfig& config) {
+    std::vector<SpatialInstance> instances;
+    instances.reserve(config.numInstances + config.numFeatures);
+    generateSynthetic(config, [&instances](const FeatureType& feature, uint32_t number, double x, double y) {
+        SpatialInstance instance;
+        instance.type = feature;
+        instance.id = feature + std::to_string(number);
+        instance.x = x;
+        instance.y = y;
+        instance.ordinal = number - 1;
+        instances.push_back(std::move(instance));
+    });
+    return instances;
+}
+
+
+bool writeSyntheticCsv(const SyntheticConfig& config, const std::string& path) {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+
+    out << "Feature,Instance,LocX,LocY\n";
+    out.precision(10);
+    generateSynthetic(config, [&out](const FeatureType& feature, uint32_t number, double x, double y) {
+        out << feature << ',' << number << ',' << x << ',' << y << '\n';
+    });
+    return static_cast<bool>(out);
+}
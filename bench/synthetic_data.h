@@ -0,0 +1,60 @@
+/**
+ * @file synthetic_data.h
+ * @brief Synthetic co-location datasets with planted patterns among Poisson noise
+ *
+ * Feature frequencies follow a Zipf law (rarity skew). A number of random patterns is
+ * planted as clusters: each cluster places one instance of every pattern feature within
+ * clusterSpread * neighborDistance / 2 of a random center, so all of them are pairwise
+ * neighbors. The remaining instances of every feature are Poisson noise: scattered
+ * uniformly (a homogeneous Poisson process given its count) over a square whose side
+ * keeps the expected number of instances per neighborDistance^2 cell at noiseDensity,
+ * so datasets of different sizes have the same local density.
+ */
+
+#pragma once
+#include "types.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Parameters of a synthetic dataset
+ */
+struct SyntheticConfig {
+    size_t numInstances = 100000;   ///< Total number of instances
+    size_t numFeatures = 20;        ///< Number of feature types
+    double raritySkew = 1.0;        ///< Zipf exponent of the feature frequencies (0 = uniform)
+    size_t patternCount = 5;        ///< Number of planted patterns
+    size_t patternSize = 4;         ///< Features per planted pattern
+    double patternPrevalence = 0.5; ///< Share of the rarest pattern feature's instances placed in clusters
+    double clusterSpread = 0.5;     ///< Cluster diameter as a fraction of neighborDistance (smaller = denser)
+    double noiseDensity = 2.0;      ///< Expected instances per neighborDistance x neighborDistance cell
+    double neighborDistance = 100.0;///< Neighbor distance the dataset is designed for
+    uint64_t seed = 42;             ///< Random seed (same seed and parameters = same dataset)
+};
+
+/**
+ * @brief Generate a dataset, passing every instance to emit
+ *
+ * Instances are produced feature by feature with per-feature ordinals, so datasets of
+ * tens of millions of instances can be streamed to a file without holding them.
+ *
+ * @param emit Called as emit(feature, instanceNumber, x, y); instanceNumber starts at 1
+ * @return Side length of the generated square
+ */
+double generateSynthetic(
+    const SyntheticConfig& config,
+    const std::function<void(const FeatureType&, uint32_t, double, double)>& emit
+);
+
+/**
+ * @brief Generate a dataset in memory (ordinals assigned per feature)
+ */
+std::vector<SpatialInstance> generateSyntheticInstances(const SyntheticConfig& config);
+
+/**
+ * @brief Stream a dataset to a CSV file readable by DataLoader::load_csv
+ * @return false if the file cannot be written
+ */
+bool writeSyntheticCsv(const SyntheticConfig& config, const std::string& path);
@@ -4,9 +4,11 @@
 #include <iostream>
 #include <algorithm>
 #include <map>
+#include <unordered_map>
 #include "neighborhood_mgr.h" // To use struct OrderedNeigh and FeatureType
 #include "types.h"
 #include "utils.h"
+#include "feature_ranking.h"
 
 // --- [IMPORTANT] FORWARD DECLARATION ---
 class NeighborhoodMgr;
@@ -45,6 +47,10 @@ class NRTree {
 private:
     NRNode* root;
 
+    // Star index: for each center feature, the INSTANCE_NODE of every center by instance ordinal
+    // (nullptr when the instance has no ordered neighbors)
+    std::unordered_map<FeatureType, std::vector<const NRNode*>> starIndex;
+
     // Recursive function to print tree (for debugging purposes)
     void printRecursive(NRNode* node, int level) const;
 
@@ -54,11 +60,17 @@ public:
 
     // Most important function: Build tree from NeighborhoodMgr results
     // According to paper: features must be sorted by instance count (ascending)
-    void build(const NeighborhoodMgr& neighMgr, const std::map<FeatureType, int>& featureCounts, const std::vector<SpatialInstance>& instances);
+    // Uses the precomputed ranking, so the build is linear in the size of the tree
+    void build(const NeighborhoodMgr& neighMgr, const FeatureRanking& ranking);
 
     // Function to print tree to screen for verification
     void printTree() const;
 
     // Getter for root if external processing needed
     const NRNode* getRoot() const { return root; }
+
+    // Find the star (INSTANCE_NODE) of an instance in O(1); nullptr if it has no ordered neighbors
+    // Children of the star are FEATURE_NODEs in feature order, each holding one INSTANCE_VECTOR_NODE
+    // whose instances are sorted by ordinal
+    const NRNode* findStar(const SpatialInstance* instance) const;
 };
\ No newline at end of file
@@ -0,0 +1,79 @@
+/**
+ * @file alloc_tracker.h
+ * @brief Heap allocation counts, bytes and peak live bytes per stage and level
+ *
+ * Builds with ENABLE_ALLOC_TRACKING (CMake option of the same name) replace the global
+ * operator new / delete. Each allocation carries a small header with its size, and once
+ * AllocationTracker::enable() has been called, every thread adds its allocations, frees
+ * and bytes to a counter slot of its own. Live bytes are batched per thread and folded
+ * into one process-wide total every few kilobytes, so peak live bytes are exact to
+ * within that batch per thread.
+ *
+ * StageTimer reads the counters at both ends of a stage and keeps a peak window open in
+ * between, so every pipeline stage and mining level reports its own allocation traffic.
+ * Over-aligned allocations (operator new with std::align_val_t) and malloc are not
+ * counted. Without ENABLE_ALLOC_TRACKING nothing is replaced and enable() returns false.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Allocation traffic (totals, or deltas between two reads)
+ */
+struct AllocationStats {
+    uint64_t allocations = 0;   ///< Calls of operator new
+    uint64_t deallocations = 0; ///< Calls of operator delete on counted allocations
+    uint64_t bytes = 0;         ///< Bytes requested by the counted allocations
+    int64_t liveBytes = 0;      ///< Counted bytes not yet freed (at the time of the read)
+    int64_t peakLiveBytes = 0;  ///< Highest live bytes during a stage (set by StageTimer)
+    bool available = false;     ///< Whether allocations were being counted
+
+    /** @brief Difference this - earlier of the counts (live and peak are kept from this) */
+    AllocationStats since(const AllocationStats& earlier) const;
+};
+
+/**
+ * @brief Process-wide switch and counters of the allocation tracker
+ */
+class AllocationTracker {
+public:
+    /**
+     * @brief Start counting allocations
+     * @return false if the build has no ENABLE_ALLOC_TRACKING
+     */
+    static bool enable();
+
+    /** @brief Whether allocations are being counted */
+    static bool active();
+
+    /** @brief Current totals over all threads */
+    static AllocationStats read();
+
+    /** @brief Open a peak window at the current live bytes (-1 if none is free or not active) */
+    static int openPeakWindow();
+
+    /** @brief Highest live bytes since the window was opened */
+    static int64_t peakOf(int window);
+
+    /** @brief Release a window of openPeakWindow */
+    static void closePeakWindow(int window);
+};
+
+/**
+ * @brief Peak window held for the lifetime of the object
+ */
+class AllocationPeakWindow {
+public:
+    AllocationPeakWindow() : window(AllocationTracker::openPeakWindow()) {}
+    ~AllocationPeakWindow() { AllocationTracker::closePeakWindow(window); }
+
+    AllocationPeakWindow(const AllocationPeakWindow&) = delete;
+    AllocationPeakWindow& operator=(const AllocationPeakWindow&) = delete;
+
+    int64_t peak() const { return AllocationTracker::peakOf(window); }
+
+private:
+    int window;
+};
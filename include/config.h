@@ -10,6 +10,8 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include "constants.h"
+#include "types.h"
 
 /**
  * @brief Configuration structure for application settings
@@ -21,11 +23,23 @@ struct AppConfig {
     // I/O Settings
     std::string datasetPath;    ///< Path to input CSV dataset file
     std::string outputPath;     ///< Path to output results file
+    std::string reportPath;     ///< Path of the JSON performance report (empty = no report; "none" in the file)
+    std::string tracePath;      ///< Path of the Chrome trace-event file (empty = no trace; needs ENABLE_TRACING)
 
     // Algorithm Parameters
-    double neighborDistance;    ///< Distance threshold for spatial neighbors
+    double neighborDistance;    ///< Distance threshold for spatial neighbors (meters in geodesic mode)
     double minPrev;            ///< Minimum prevalence threshold (0.0 to 1.0)
     double minCondProb;        ///< Minimum conditional probability for rules (0.0 to 1.0)
+    size_t maxPatternSize;     ///< Largest pattern size to mine (0 = unlimited)
+    MiningStrategy miningStrategy; ///< Level-wise or depth-first search
+    size_t memoryBudgetMB;     ///< Table memory above which tables are spilled to disk (0 = unlimited)
+    unsigned memorySampleMs;   ///< Interval of the RSS timeline in the run report (0 = stage boundaries only)
+    bool hardwareCounters;     ///< Count cycles, instructions and cache/branch/TLB misses per stage (Linux perf)
+    bool allocationTracking;   ///< Count heap allocations per stage (builds with ENABLE_ALLOC_TRACKING)
+
+    // Spatial Index Settings
+    size_t cellSplitThreshold; ///< Grid cell occupancy above which the cell is refined into a quadtree
+    CoordinateSystem coordinateSystem; ///< Planar coordinates or longitude/latitude degrees
 
     // System Settings
     bool debugMode;            ///< Enable debug output messages
@@ -39,9 +53,19 @@ struct AppConfig {
     AppConfig()
         : datasetPath("data/sample_data.csv"),
           outputPath("src/c++/output/rules.txt"),
+          reportPath("../report.json"),
+          tracePath(""),
           neighborDistance(5.0),
           minPrev(0.6),
           minCondProb(0.5),
+          maxPatternSize(0),
+          miningStrategy(MiningStrategy::LEVEL_WISE),
+          memoryBudgetMB(0),
+          memorySampleMs(50),
+          hardwareCounters(false),
+          allocationTracking(false),
+          cellSplitThreshold(Constants::DEFAULT_CELL_SPLIT_THRESHOLD),
+          coordinateSystem(CoordinateSystem::PLANAR),
           debugMode(false) {}
 };
 
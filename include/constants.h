@@ -7,6 +7,7 @@
  */
 
 #pragma once
+#include <cstddef>
 
 namespace Constants {
     // Epsilon values for numerical stability
@@ -20,4 +21,17 @@ namespace Constants {
     constexpr double DEFAULT_MIN_PREVALENCE = 0.6;  ///< Default minimum prevalence threshold
     constexpr double DEFAULT_MIN_COND_PROB = 0.5;   ///< Default minimum conditional probability
     constexpr double DEFAULT_NEIGHBOR_DISTANCE = 5.0; ///< Default neighbor distance threshold
+
+    // Spatial index refinement
+    constexpr size_t DEFAULT_CELL_SPLIT_THRESHOLD = 64;  ///< Grid cells holding more points are refined into a quadtree
+    constexpr int MAX_QUADTREE_DEPTH = 16;               ///< Depth limit for quadtree refinement (guards duplicate points)
+
+    // Geodesic coordinates
+    constexpr double EARTH_RADIUS_METERS = 6371008.8;   ///< Mean Earth radius used for great-circle distances
+    constexpr double GEODESIC_GRID_MARGIN = 1e-6;       ///< Relative slack on the projected grid cell size (rounding only)
+    constexpr double MIN_PROJECTION_COS = 1e-6;         ///< Below this cos(latitude) bound the projection drops longitude (latitude band scan)
+
+    // Table instance generation
+    constexpr size_t PR_BOUND_CHECK_INTERVAL = 64;      ///< Prefix rows between two PR upper-bound checks
+    constexpr size_t MAX_FIXED_ROW_WIDTH = 8;           ///< Widest table row with a compile-time specialization
 }
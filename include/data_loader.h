@@ -24,10 +24,12 @@ public:
      * - Instance: Instance number (integer)
      * - LocX: X coordinate (double)
      * - LocY: Y coordinate (double)
+     * Columns named X and Y are accepted in place of LocX and LocY.
      * 
      * @param filepath Path to the CSV file
      * @return std::vector<SpatialInstance> Vector of loaded spatial instances
      * @note Instance IDs are generated as: FeatureType + InstanceNumber (e.g., "A1", "B2")
+     * @note Ordinals are assigned per feature type in file order (0, 1, 2, ...)
      */
     static std::vector<SpatialInstance> load_csv(const std::string& filepath);
 };
\ No newline at end of file
@@ -0,0 +1,74 @@
+/**
+ * @file feature_ranking.h
+ * @brief Feature order of the mining algorithm, computed once per dataset
+ */
+
+#pragma once
+#include "types.h"
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+
+/**
+ * @brief Rank, instance count and ordering of every feature type
+ * 
+ * Features are ranked by ascending instance count, ties broken by name (Algorithm 1
+ * Step 2). The ranking is built once after loading and shared by the neighborhood
+ * manager, the NR-tree and the miner, so no stage has to recount instances.
+ * Counts are taken from SpatialInstance::type, so feature names may be any string.
+ */
+class FeatureRanking {
+public:
+    FeatureRanking() = default;
+
+    /**
+     * @brief Count the instances of every feature and rank the features
+     * @param instances All spatial instances of the dataset
+     */
+    explicit FeatureRanking(const std::vector<SpatialInstance>& instances);
+
+    /**
+     * @brief Rank features from precomputed instance counts
+     * @param featureCounts Map of instance counts for all features
+     */
+    explicit FeatureRanking(const std::map<FeatureType, int>& featureCounts);
+
+    /** @brief Number of features */
+    size_t size() const { return sortedFeatures.size(); }
+
+    /** @brief Features in rank order (ascending instance count) */
+    const std::vector<FeatureType>& features() const { return sortedFeatures; }
+
+    /** @brief Instance counts of all features */
+    const std::map<FeatureType, int>& counts() const { return featureCounts; }
+
+    /** @brief Rank of a feature (throws std::out_of_range for an unknown feature) */
+    size_t rank(const FeatureType& feature) const { return ranks.at(feature); }
+
+    /** @brief Whether the feature occurs in the dataset */
+    bool contains(const FeatureType& feature) const { return ranks.count(feature) != 0; }
+
+    /** @brief Instance count of a feature (0 for an unknown feature) */
+    int count(const FeatureType& feature) const;
+
+    /** @brief True if a comes before b in feature order */
+    bool less(const FeatureType& a, const FeatureType& b) const { return rank(a) < rank(b); }
+
+    /** @brief Comparator object for std::sort and friends */
+    struct Less {
+        const FeatureRanking* ranking;
+        bool operator()(const FeatureType& a, const FeatureType& b) const { return ranking->less(a, b); }
+    };
+    Less comparator() const { return Less{ this }; }
+
+    /** @brief Sort features in place into feature order */
+    void sort(std::vector<FeatureType>& features) const;
+
+private:
+    std::vector<FeatureType> sortedFeatures;
+    std::map<FeatureType, int> featureCounts;
+    std::unordered_map<FeatureType, size_t> ranks;
+
+    void rankFeatures();
+};
@@ -0,0 +1,18 @@
+/**
+ * @file json_util.h
+ * @brief Helpers shared by the JSON writers (run report, trace events)
+ */
+
+#pragma once
+#include <string>
+
+/**
+ * @brief Quote and escape text as a JSON string literal
+ *
+ * Quotes, backslashes and control characters are escaped (\n, \r, \t, otherwise
+ * \uXXXX), so any feature name or path survives a round trip through a JSON parser.
+ *
+ * @param text Raw text
+ * @return std::string The text in double quotes
+ */
+std::string jsonString(const std::string& text);
@@ -0,0 +1,64 @@
+/**
+ * @file level_arena.h
+ * @brief Per-thread monotonic arenas holding the structures of one mining level
+ *
+ * A level allocates its extension sets (and the tables whose size is known up front)
+ * from a LevelArena: one std::pmr::monotonic_buffer_resource per OpenMP thread, so the
+ * parallel prefix groups allocate without taking a lock and without sharing heap
+ * structures. Deallocation is a no-op; all memory of the level is returned at once
+ * when the arena is destroyed, after the next level has consumed its tables.
+ */
+
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+class LevelArena {
+public:
+    /** @brief One arena for each thread of the OpenMP team (one without OpenMP) */
+    LevelArena();
+
+    LevelArena(const LevelArena&) = delete;
+    LevelArena& operator=(const LevelArena&) = delete;
+
+    /**
+     * @brief Arena of the calling thread (inside or outside a parallel region)
+     *
+     * A thread never shares its arena: parallel regions using the arena must not run more
+     * threads than threads() (pass it as num_threads) and must not be nested.
+     *
+     * @throws std::logic_error If the thread number has no arena of its own, or the
+     *         calling thread is in a nested parallel region
+     */
+    std::pmr::memory_resource* local();
+
+    /** @brief Number of arenas: the largest team that may allocate from the level */
+    size_t threads() const { return arenas.size(); }
+
+    /** @brief Bytes all arenas of the level obtained from the heap */
+    size_t bytesReserved() const;
+
+private:
+    /**
+     * @brief Heap resource that counts the bytes it hands out (upstream of an arena)
+     */
+    class CountingResource : public std::pmr::memory_resource {
+    public:
+        size_t reserved = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    /** @brief Arena of one thread (upstream is declared first, so it outlives the buffer) */
+    struct ThreadArena {
+        CountingResource upstream;
+        std::pmr::monotonic_buffer_resource buffer{ &upstream };
+    };
+
+    std::vector<std::unique_ptr<ThreadArena>> arenas;
+};
@@ -9,9 +9,19 @@
 #pragma once
 #include "types.h"
 #include "neighborhood_mgr.h"
+#include "utils.h"
+#include "pattern_mask.h"
+#include "pattern_metrics.h"
+#include "feature_ranking.h"
+#include "table_instance.h"
+#include "table_spill.h"
+#include "run_report.h"
+#include "level_arena.h"
 #include <vector>
 #include <map>
 #include <functional>
+#include <unordered_map>
+#include <memory>
 
 /**
  * @brief Progress callback function type
@@ -21,6 +31,24 @@
  */
 using ProgressCallback = std::function<void(int, int, const std::string&, double)>;
 
+/**
+ * @brief Options of a mining run
+ */
+struct MiningOptions {
+    size_t maxPatternSize = 0;                            ///< Largest pattern size to mine (0 = unlimited)
+    MiningStrategy strategy = MiningStrategy::LEVEL_WISE; ///< Search order
+    size_t memoryBudgetMB = 0;                            ///< Table memory above which tables are spilled to disk (0 = unlimited)
+    bool debugOutput = false;                             ///< Print candidate diagnostics to stdout (lines of concurrent runs interleave)
+};
+
+/**
+ * @brief Participants and row count of one ordered feature pair, counted from the stars
+ */
+struct PairParticipation {
+    std::vector<InstanceBitmap> bitmaps;  ///< Participating instances of both features, in pattern order
+    size_t rowCount = 0;                  ///< Rows of T({f_center, f_neighbor}): star neighbors summed over centers
+};
+
 /**
  * @brief JoinlessMiner class implementing the joinless colocation mining algorithm
  * 
@@ -33,20 +61,320 @@ private:
     double minPrev;                          ///< Minimum prevalence threshold
     NRTree* orderedNRTree;                   ///< Non-owning pointer to ordered NR-tree
     ProgressCallback progressCallback;        ///< Progress reporting callback
+    bool debugOutput = false;                 ///< Candidate diagnostics to stdout (MiningOptions::debugOutput)
+    FeatureRanking ranking;                   ///< Feature order of the current run
+    RareWeightTable rareWeights;              ///< 1 / RI(f, C) per (feature rank, f_min rank)
+    InstanceLookup instanceLookup;            ///< Resolves the ordinals of packed rows to instances
+    std::vector<LevelStats> levelStatistics;  ///< Counts and resources per pattern size of the last run
 
-    std::map<Colocation, std::vector<ColocationInstance>> genTableInstance(
+    /**
+     * @brief Generate table instances of size-k candidates from size-(k-1) tables
+     * 
+     * Candidates are grouped by their (k-1)-prefix; each prefix table is walked once for
+     * all of its new features (see extendPrefix), and prefix groups run in parallel.
+     * Candidates abandoned early (their PR bound cannot reach minPrev) get no table.
+     * Prefix tables missing from prevTableInstances are read back from prevSpilled; if one
+     * cannot be read, the exception of SpilledTables::load is rethrown after the parallel
+     * loop and the run is aborted.
+     * 
+     * With a budget, the tables of every prefix group are accounted as the group finishes;
+     * tables that would take the level past the budget are written to spilled instead of
+     * being returned, so the level never holds much more than the budget in tables. Groups
+     * extended after the first spill carry no extension sets.
+     * 
+     * @param prevSpilled Previous-level tables spilled to disk (may be nullptr)
+     * @param minPrev Minimum prevalence threshold (for early abandoning)
+     * @param countOnly Only count participation: no rows or extension sets are kept
+     *        (used when no (k+1)-level can follow)
+     * @param budgetBytes Memory budget for the tables of the level (0 = unlimited)
+     * @param spilled Tables of the level written to disk (created on the first spill)
+     * @param heldBytes Output bytes of the tables kept in memory while the level was
+     *        generated, including tables the caller drops as non-prevalent (0 if countOnly)
+     * @param arena Arena of the level; each prefix group allocates its extension sets
+     *        from the arena of the thread that extends it
+     * @param extensions Output extension sets of the generated tables
+     * @param participation Output PRs and row count of each candidate with prefix rows
+     */
+    std::map<Colocation, PackedTable> genTableInstance(
         const std::vector<Colocation>& candidates,
-        const std::map<Colocation, std::vector<ColocationInstance>>& prevTableInstances,
-		const NRTree& orderedNRTree
+        const std::map<Colocation, PackedTable>& prevTableInstances,
+        const std::map<Colocation, ExtensionTable>& prevExtensions,
+        const SpilledTables* prevSpilled,
+		const NRTree& orderedNRTree,
+        double minPrev,
+        bool countOnly,
+        size_t budgetBytes,
+        std::unique_ptr<SpilledTables>& spilled,
+        size_t& heldBytes,
+        LevelArena& arena,
+        std::map<Colocation, ExtensionTable>& extensions,
+        std::map<Colocation, PatternMetrics>& participation
+    );
+
+    /**
+     * @brief Extend one prefix table with several new features in a single pass
+     * 
+     * Every prefix row I is visited once; for each new feature f it is extended with the
+     * instances o of S(I, f) (carried in prefixExt, or recomputed if not carried), and the
+     * new rows get S(I ∪ {o}, g) = S(I, g) ∩ Neigh(o, g) for the new features g after f.
+     * 
+     * Participants are marked in per-position bitmaps while rows are generated. Every
+     * PR_BOUND_CHECK_INTERVAL prefix rows, PR(f_i) is bounded by (participants so far +
+     * distinct instances in the unprocessed prefix rows) / num(f_i) — for the new feature
+     * by the remaining carried |S(I, f)| — and a candidate whose weighted bound falls below
+     * minPrev is dropped together with its rows.
+     * 
+     * The work is done by extendPrefixRows, specialized for the row width of the level.
+     * 
+     * @param prefix The (k-1)-prefix pattern
+     * @param prefixRows Table instance of the prefix
+     * @param prefixExt Extension sets carried by the prefix rows (may be nullptr)
+     * @param newFeatures Features appended to the prefix, one per candidate
+     * @param orderedNRTree The ordered NR-tree
+     * @param minPrev Minimum prevalence threshold
+     * @param countOnly Stream S(I, f) into the bitmaps without building rows or sets
+     * @param resource Memory resource of the new extension sets
+     * @param rowsPerFeature Output rows, one table per new feature
+     * @param extensionsPerFeature Output extension sets, one per new feature (sets are
+     *        empty when S(I, f) was not carried or no set is kept)
+     * @param metricsPerFeature Output PRs and row count per new feature (exact = false and
+     *        PRs are upper bounds for dropped candidates)
+     * @param keepFeatures Features whose S sets the new rows keep (nullptr: the other new
+     *        features ranked after f)
+     */
+    void extendPrefix(
+        const Colocation& prefix,
+        const PackedTable& prefixRows,
+        const ExtensionTable* prefixExt,
+        const std::vector<FeatureType>& newFeatures,
+        const NRTree& orderedNRTree,
+        double minPrev,
+        bool countOnly,
+        std::pmr::memory_resource* resource,
+        std::vector<PackedTable>& rowsPerFeature,
+        std::vector<ExtensionTable>& extensionsPerFeature,
+        std::vector<PatternMetrics>& metricsPerFeature,
+        const std::vector<FeatureType>* keepFeatures
+    );
+
+    /**
+     * @brief extendPrefix for new rows of Width ordinals
+     * 
+     * @tparam Width Row width of prefix + f (2..MAX_FIXED_ROW_WIDTH), or DYNAMIC_ROW_WIDTH
+     */
+    template <size_t Width>
+    void extendPrefixRows(
+        const Colocation& prefix,
+        const PackedTable& prefixRows,
+        const ExtensionTable* prefixExt,
+        const std::vector<FeatureType>& newFeatures,
+        const NRTree& orderedNRTree,
+        double minPrev,
+        bool countOnly,
+        std::pmr::memory_resource* resource,
+        std::vector<PackedTable>& rowsPerFeature,
+        std::vector<ExtensionTable>& extensionsPerFeature,
+        std::vector<PatternMetrics>& metricsPerFeature,
+        const std::vector<FeatureType>* keepFeatures
     );
 
-   
+    /**
+     * @brief Neigh(o, g) for each feature g of a feature-ordered list, read from the star of o
+     * 
+     * @param star INSTANCE_NODE of o (may be nullptr)
+     * @param features Features in feature order
+     * @param ranks Rank of each entry of features
+     * @return Pointers to the neighbor lists (nullptr where o has no neighbor of that feature)
+     */
+    std::vector<const std::vector<const SpatialInstance*>*> starNeighborSets(
+        const NRNode* star,
+        const std::vector<FeatureType>& features,
+        const std::vector<size_t>& ranks
+    ) const;
+
+    /**
+     * @brief Drop extension sets that no (k+1)-candidate can use
+     * 
+     * Non-prevalent patterns lose all sets; a prevalent pattern prefix + f keeps the set
+     * of feature g only if prefix + g is prevalent as well (otherwise prefix + f + g is
+     * never generated).
+     */
+    void trimExtensions(
+        std::map<Colocation, ExtensionTable>& extensions,
+        const std::vector<Colocation>& prevalent
+    );
+
+    /**
+     * @brief Erase the tables of non-prevalent patterns (they are never prefixes)
+     */
+    void dropNonPrevalentTables(
+        std::map<Colocation, PackedTable>& tableInstances,
+        const std::vector<Colocation>& prevalent
+    );
+
+    /**
+     * @brief Spill the largest tables to disk until the rest fits into the budget
+     * 
+     * Spilled tables are removed from tableInstances together with their extension sets
+     * (those are recomputed when the table is read back as a prefix).
+     * 
+     * @param budgetBytes Memory budget for the tables of one level
+     * @param spilled Tables of the level on disk (created on the first spill)
+     */
+    void spillOverBudget(
+        std::map<Colocation, PackedTable>& tableInstances,
+        std::map<Colocation, ExtensionTable>& extensions,
+        size_t budgetBytes,
+        std::unique_ptr<SpilledTables>& spilled
+    );
+
+    /**
+     * @brief Release the level arena early if most of it is no longer referenced
+     * 
+     * Sets of non-prevalent, abandoned, trimmed or spilled patterns stay in the arena until
+     * it is released. If the kept sets take less than half of it, they are copied into a
+     * fresh arena and the old one is released at once instead of after the next level.
+     */
+    void compactExtensions(
+        std::map<Colocation, ExtensionTable>& extensions,
+        std::unique_ptr<LevelArena>& arena
+    );
+
+    /**
+     * @brief Bytes held by the tables of a level together with their extension sets
+     */
+    size_t levelTableBytes(
+        const std::map<Colocation, PackedTable>& tableInstances,
+        const std::map<Colocation, ExtensionTable>& extensions
+    ) const;
+
+    /**
+     * @brief Evaluate candidates from the participation counted during generation
+     * 
+     * @param participation PRs and row count per candidate (see genTableInstance)
+     * @param metricsStore Output: PR, PI, WPI and row count of every candidate
+     * @return Prevalent candidates (WPI >= minPrev), in input order
+     */
     std::vector<Colocation> selectPrevColocations(
         const std::vector<Colocation>& candidates,
-        const std::map<Colocation, std::vector<ColocationInstance>>& tableInstances,
+        const std::map<Colocation, PatternMetrics>& participation,
         double minPrev,
-        const std::map<FeatureType, int>& featureCount, // Cần thêm để tính PR/RI
-        double delta
+        PatternMetricsStore& metricsStore
+    );
+
+    /**
+     * @brief Derive PI, WPI and the prevalent flag of a level from the participation ratios
+     * 
+     * WPI = min PR(f, C) / RI(f, C) is evaluated for all candidates at once from the
+     * precomputed weight table (f_min of a feature-ordered pattern is its first feature).
+     * 
+     * @param candidates Size-k candidates (all of the same size)
+     * @param metrics Metrics of each candidate with participationRatios filled in
+     * @param minPrev Minimum prevalence threshold
+     */
+    void fillPrevalence(
+        const std::vector<Colocation>& candidates,
+        std::vector<PatternMetrics>& metrics,
+        double minPrev
+    );
+
+    /**
+     * @brief filterCandidates on pattern masks of a given width
+     * 
+     * Subsets are found by clearing one bit of the candidate mask and probing an
+     * open-addressing hash map over the patterns of prevMetrics.
+     * 
+     * @tparam Mask FeatureMask<1>, FeatureMask<2> or DynamicFeatureMask
+     * @param featureRanking Feature order; the bit of a feature is its rank
+     */
+    template <typename Mask>
+    std::vector<Colocation> filterCandidatesWithMasks(
+        const std::vector<Colocation>& candidates,
+        const PatternMetricsStore& prevMetrics,
+        double minPrev,
+        const FeatureRanking& featureRanking
+    );
+
+    /**
+     * @brief Lemma 2 and Lemma 3 check of one candidate against evaluated patterns
+     * 
+     * @param metricsIndex Mask of every pattern in metrics -> its index
+     * @param metrics Metrics of the evaluated (k-1)-patterns
+     * @return bool False if the candidate is pruned
+     */
+    template <typename Mask>
+    bool passesSubsetPruning(
+        const Colocation& candidate,
+        const MaskHashMap<Mask>& metricsIndex,
+        const PatternMetricsStore& metrics,
+        double minPrev,
+        const FeatureRanking& featureRanking
+    ) const;
+
+    /**
+     * @brief Depth-first mining engine (MiningStrategy::DEPTH_FIRST)
+     * 
+     * Visits single-feature patterns in reverse feature order and, below each pattern,
+     * evaluates all children count-only before descending into the prevalent ones, last
+     * feature first. In this reverse-lexicographic pre-order every (k-1)-subset of a
+     * candidate is evaluated before the candidate, so Lemma 2 and Lemma 3 read the same
+     * information as in the level-wise miner from a cache of all evaluated patterns.
+     * Only the table instances of the patterns on the current path are kept.
+     * 
+     * @return All prevalent patterns, ordered by size and then feature order
+     */
+    template <typename Mask>
+    std::vector<Colocation> mineDepthFirst(
+        double minPrev,
+        const NRTree& orderedNRTree,
+        const MiningOptions& options
+    );
+
+    /**
+     * @brief Fused k=2 stage: participation bitmaps and row count of every ordered feature pair
+     * 
+     * Walks the star neighborhoods of the NR-tree once. For a star of center c and
+     * neighbor feature f, c participates in {type(c), f} together with every listed
+     * neighbor, and each listed neighbor is one row of T({type(c), f}). No size-2 table
+     * instance rows are built.
+     * 
+     * @param orderedNRTree The ordered NR-tree
+     * @param featureCount Map of instance counts for all features (bitmap sizes)
+     * @return Map from pair {f_center, f_neighbor} to its bitmaps and row count
+     */
+    std::map<Colocation, PairParticipation> countPairParticipation(
+        const NRTree& orderedNRTree,
+        const std::map<FeatureType, int>& featureCount
+    );
+
+    /**
+     * @brief Materialize size-2 table instances for the given pairs only
+     * 
+     * Extension sets of a row {c, n} are kept for every feature g after type(n) such
+     * that {type(c), g} is one of the given pairs: S = Neigh(c, g) ∩ Neigh(n, g).
+     * 
+     * Pairs are built one at a time. With a budget, every finished table is accounted
+     * before the next one is built; tables that would take the level past the budget are
+     * written to spilled instead of being returned, and pairs built after the first spill
+     * carry no extension sets (as in genTableInstance).
+     * 
+     * @param pairs Size-2 patterns (typically the prevalent ones)
+     * @param orderedNRTree The ordered NR-tree
+     * @param budgetBytes Memory budget for the tables of the level (0 = unlimited)
+     * @param spilled Tables of the level written to disk (created on the first spill)
+     * @param heldBytes Output bytes of the returned tables and their extension sets
+     * @param arena Arena of the level (the extension sets are allocated from it)
+     * @param extensions Output extension sets of the generated tables
+     * @return Map from pair to its table instance rows {center, neighbor}
+     */
+    std::map<Colocation, PackedTable> genPairTableInstance(
+        const std::vector<Colocation>& pairs,
+        const NRTree& orderedNRTree,
+        size_t budgetBytes,
+        std::unique_ptr<SpilledTables>& spilled,
+        size_t& heldBytes,
+        LevelArena& arena,
+        std::map<Colocation, ExtensionTable>& extensions
     );
 
 
@@ -60,49 +388,69 @@ public:
      * colocation patterns that meet the minimum prevalence threshold.
      * 
      * @param minPrevalence Minimum prevalence threshold (0.0 to 1.0)
-     * @param nbrMgr Pointer to neighborhood manager containing star neighborhoods
-     * @param instances Vector of all spatial instances
+     * @param orderedNRTree Ordered NR-tree of the star neighborhoods
+     * @param featureRanking Feature order and instance counts of the dataset
+     * @param options Run options (maximum pattern size, search strategy)
      * @param progressCb Optional callback for progress reporting
      * @return std::vector<Colocation> All discovered prevalent colocation patterns
      */
     std::vector<Colocation> mineColocations(
         double minPrevalence, 
-        NRTree& orderedNRTree, 
-        const std::vector<SpatialInstance>& instances,
-		const std::map<FeatureType, int>& featureCount,
+        const NRTree& orderedNRTree, 
+		const FeatureRanking& featureRanking,
+        const MiningOptions& options = MiningOptions(),
         ProgressCallback progressCb = nullptr
     );
+
+    /**
+     * @brief Per-level statistics of the last mineColocations call, by pattern size
+     * 
+     * Level-wise runs record every level that was evaluated. Depth-first runs have no
+     * levels; their counts are summed per pattern size, with no timing or table bytes.
+     */
+    const std::vector<LevelStats>& levelStats() const { return levelStatistics; }
     
     /**
      * @brief Generate (k+1)-size candidate patterns from k-size prevalent patterns
      * 
-     * Uses Apriori-gen approach: joins patterns with matching (k-1) prefixes
-     * and prunes candidates whose subsets are not all prevalent.
+     * Uses Apriori-gen approach: joins patterns with matching (k-1) prefixes.
+     * Patterns are grouped by prefix in a lexicographically sorted list (feature order:
+     * ascending instance count), and only patterns inside a group are joined.
      * 
      * @param prevPrevalent Vector of k-size prevalent patterns
-     * @return std::vector<Colocation> Generated (k+1)-size candidate patterns
+     * @param featureRanking Feature order of the dataset
+     * @return std::vector<Colocation> Generated (k+1)-size candidates, sorted and unique
      */
     std::vector<Colocation> generateCandidates(
         const std::vector<Colocation>& prevPrevalent,
-        const std::map<FeatureType, int>& featureCount
+        const FeatureRanking& featureRanking
     );
 
+    /**
+     * @brief Prune candidates with Lemma 2 (prevalent subsets) and Lemma 3 (PI upper bound)
+     * 
+     * Both lemmas read the previous level's metrics store: Lemma 2 needs the prevalent
+     * flag of the subsets containing f_min, Lemma 3 the PI of the subset without f_min.
+     * 
+     * @param prevMetrics Metrics of every (k-1)-candidate evaluated at the previous level
+     * @param delta Global degree of dispersion; the weight table is rebuilt if it was built
+     *        from another ranking or delta
+     */
     std::vector<Colocation> filterCandidates(
         const std::vector<Colocation>& candidates,
-		const std::vector<Colocation>& prevPrevalent,
-		const std::map<Colocation, std::vector<ColocationInstance>>& tableInstance,
+		const PatternMetricsStore& prevMetrics,
 		double minPrev,
-		std::map<FeatureType, int> featureCount,
+		const FeatureRanking& featureRanking,
 		double delta
     );
 
 
-    std::vector<const SpatialInstance*> JoinlessMiner::findNeighbors(
+    std::vector<const SpatialInstance*> findNeighbors(
         const NRTree& tree,
         const SpatialInstance* instance,
         const FeatureType& featureType
     );
-    std::vector<const SpatialInstance*> JoinlessMiner::findExtendedSet(
+    std::vector<const SpatialInstance*> findExtendedSet(
         const NRTree& tree,
         const ColocationInstance& instance,
         const FeatureType& featureType
@@ -0,0 +1,112 @@
+/**
+ * @file mining_session.h
+ * @brief Dataset loaded and indexed once, then mined at many thresholds
+ *
+ * A MiningSession runs the index stages of the pipeline (load, grid join, neighborhood
+ * build, NR-tree build) once in its constructor and keeps the ordered NR-tree resident.
+ * Each mine() call only runs the mining stage against it, so a series of threshold
+ * queries on the same dataset pays for the spatial join a single time.
+ *
+ * mine() is const and may be called from several threads at once: every call mines with
+ * a JoinlessMiner of its own and only reads the shared tree and feature ranking.
+ *
+ * The resources of a call (CPU time, peak RSS, faults, context switches, hardware events,
+ * allocation counts and peak live bytes) are read from process-wide counters, so they only
+ * belong to the call if no other mine() call ran at the same time. Calls that overlapped
+ * another one, in any session, keep their wall times only and have exclusive = false.
+ * Work outside mine() on other threads, such as indexing another session, is not detected.
+ */
+
+#pragma once
+#include "types.h"
+#include "constants.h"
+#include "NRTree.h"
+#include "feature_ranking.h"
+#include "miner.h"
+#include "run_report.h"
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Parameters of the spatial index a session is built with
+ */
+struct IndexOptions {
+    double neighborDistance = 5.0;                                   ///< Distance threshold for neighbors (meters in geodesic mode)
+    size_t cellSplitThreshold = Constants::DEFAULT_CELL_SPLIT_THRESHOLD; ///< Grid cell occupancy above which a cell is refined
+    CoordinateSystem coordinateSystem = CoordinateSystem::PLANAR;    ///< Planar coordinates or longitude/latitude degrees
+};
+
+/**
+ * @brief Outcome of one mine() call
+ */
+struct MiningResult {
+    std::vector<Colocation> patterns; ///< Prevalent patterns, by size, then in feature order
+    std::vector<LevelStats> levels;   ///< Per-level statistics of the run (see JoinlessMiner::levelStats)
+    StageStats resources;             ///< Time and resources of the mining stage
+    bool exclusive = true;            ///< No other mine() call overlapped this one; if false, only the
+                                      ///< wall times in resources and levels are set
+};
+
+/**
+ * @brief Called when an index stage starts, with the stage name (e.g. "grid_join")
+ */
+using StageCallback = std::function<void(const std::string& stage)>;
+
+class MiningSession {
+public:
+    /**
+     * @brief Load a CSV dataset (see DataLoader::load_csv) and index it
+     *
+     * @param datasetPath Path of the CSV file
+     * @param options Neighbor distance and grid settings
+     * @param onStage Optional callback at the start of every index stage
+     */
+    MiningSession(const std::string& datasetPath, const IndexOptions& options, const StageCallback& onStage = nullptr);
+
+    /**
+     * @brief Index instances that are already in memory
+     *
+     * Ordinals are assigned per feature type in input order; the caller's ordinals are
+     * ignored.
+     */
+    MiningSession(std::vector<SpatialInstance> dataset, const IndexOptions& options, const StageCallback& onStage = nullptr);
+
+    // The tree points into the session's neighbor pairs
+    MiningSession(const MiningSession&) = delete;
+    MiningSession& operator=(const MiningSession&) = delete;
+
+    /**
+     * @brief Mine the prevalent patterns of the resident dataset (thread-safe)
+     *
+     * Resources are only measured for calls that ran alone (see MiningResult::exclusive).
+     *
+     * @param minPrev Minimum prevalence threshold (0.0 to 1.0)
+     * @param options Run options (maximum pattern size, search strategy, memory budget)
+     * @param progressCb Optional progress callback of this run
+     * @throws std::runtime_error If a table spilled under the memory budget cannot be read back
+     */
+    MiningResult mine(double minPrev, const MiningOptions& options = MiningOptions(),
+        ProgressCallback progressCb = nullptr) const;
+
+    /** @brief Resources of the index stages run by the constructor, in order */
+    const std::vector<StageStats>& indexStages() const { return stages; }
+
+    const IndexOptions& indexOptions() const { return options; }
+    const FeatureRanking& ranking() const { return featureRanking; }
+    const NRTree& tree() const { return orderedNRTree; }
+    size_t instanceCount() const { return instances; }
+    size_t neighborPairCount() const { return neighborPairs.size(); }
+
+private:
+    /** @brief Rank the features (ending the load stage), then run the remaining index stages */
+    void index(const std::vector<SpatialInstance>& loaded, const StageTimer& loadTimer, const StageCallback& onStage);
+
+    IndexOptions options;
+    size_t instances = 0;
+    FeatureRanking featureRanking;
+    std::vector<std::pair<SpatialInstance, SpatialInstance>> neighborPairs; ///< Instances the tree points to
+    NRTree orderedNRTree;
+    std::vector<StageStats> stages;
+};
@@ -5,6 +5,7 @@
 
 #pragma once
 #include "types.h"
+#include "feature_ranking.h"
 #include <map>
 #include <vector>
 #include "NRTree.h"
@@ -24,9 +25,10 @@ public:
      * creates a star with that instance as center and all its neighbors.
      * 
      * @param pairs Vector of neighbor pairs found by spatial indexing
+     * @param ranking Feature order of the dataset
      */
     void buildFromPairs(const std::vector<std::pair<SpatialInstance, SpatialInstance>>& pairs,
-                        const std::map<FeatureType, int>&FeatureCounts);
+                        const FeatureRanking& ranking);
     
     /**
      * @brief Get the ordered neighborhood map
@@ -44,5 +46,5 @@ private:
     // Function to check ordering
     bool isOrdered(const FeatureType& centerType,
         const FeatureType& neighborType,
-        const std::map<FeatureType, int>& counts);
+        const FeatureRanking& ranking);
 };
\ No newline at end of file
@@ -0,0 +1,162 @@
+/**
+ * @file pattern_mask.h
+ * @brief Bitset encoding of co-location patterns and an open-addressing hash map over them
+ *
+ * A pattern is encoded as a set of feature bits (bit i = feature of rank i). Subset
+ * checks then become a bit-clear and a hash probe instead of building vectors of
+ * strings. Fixed-width masks (64 or 128 bits) cover the usual feature counts; a
+ * dynamically sized mask is the fallback for wider feature sets.
+ */
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/** @brief splitmix64 finalizer used to hash mask words */
+inline uint64_t mixMaskWord(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Fixed-width feature bitset with Words 64-bit words
+ */
+template <size_t Words>
+class FeatureMask {
+public:
+    /** @brief Create an empty mask (numFeatures is only checked by the dynamic variant) */
+    explicit FeatureMask(size_t numFeatures = 0) { (void)numFeatures; words.fill(0); }
+
+    void set(size_t bit) { words[bit >> 6] |= (uint64_t{ 1 } << (bit & 63)); }
+    void reset(size_t bit) { words[bit >> 6] &= ~(uint64_t{ 1 } << (bit & 63)); }
+    bool test(size_t bit) const { return (words[bit >> 6] >> (bit & 63)) & 1; }
+
+    bool empty() const {
+        for (const uint64_t word : words) {
+            if (word) return false;
+        }
+        return true;
+    }
+
+    bool operator==(const FeatureMask& other) const { return words == other.words; }
+
+    uint64_t hash() const {
+        uint64_t h = 0;
+        for (const uint64_t word : words) h = mixMaskWord(h ^ word);
+        return h;
+    }
+
+    /** @brief Largest number of features this mask can hold */
+    static constexpr size_t capacity() { return Words * 64; }
+
+private:
+    std::array<uint64_t, Words> words;
+};
+
+/**
+ * @brief Feature bitset sized at runtime (fallback for more than 128 features)
+ */
+class DynamicFeatureMask {
+public:
+    explicit DynamicFeatureMask(size_t numFeatures = 0) : words((numFeatures + 63) / 64, 0) {}
+
+    void set(size_t bit) { words[bit >> 6] |= (uint64_t{ 1 } << (bit & 63)); }
+    void reset(size_t bit) { words[bit >> 6] &= ~(uint64_t{ 1 } << (bit & 63)); }
+    bool test(size_t bit) const { return (words[bit >> 6] >> (bit & 63)) & 1; }
+
+    bool empty() const {
+        for (const uint64_t word : words) {
+            if (word) return false;
+        }
+        return true;
+    }
+
+    bool operator==(const DynamicFeatureMask& other) const { return words == other.words; }
+
+    uint64_t hash() const {
+        uint64_t h = 0;
+        for (const uint64_t word : words) h = mixMaskWord(h ^ word);
+        return h;
+    }
+
+    static constexpr size_t capacity() { return SIZE_MAX; }
+
+private:
+    std::vector<uint64_t> words;
+};
+
+/**
+ * @brief Open-addressing (linear probing) hash map from pattern mask to an index
+ *
+ * The index typically is the position of the pattern in a per-level list. The empty
+ * mask marks free slots, which is safe because patterns are never empty. The table
+ * doubles when it becomes half full, so it can also grow incrementally.
+ */
+template <typename Mask>
+class MaskHashMap {
+public:
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    /**
+     * @brief Create a map sized for the expected number of patterns (load factor <= 0.5)
+     * @param expected Expected number of entries
+     * @param numFeatures Number of features (mask width)
+     */
+    MaskHashMap(size_t expected, size_t numFeatures) : numFeatures(numFeatures) {
+        size_t capacity = 16;
+        while (capacity < expected * 2) capacity <<= 1;
+        slots.assign(capacity, Mask(numFeatures));
+        values.assign(capacity, NOT_FOUND);
+        bitmask = capacity - 1;
+    }
+
+    /** @brief Insert or overwrite the index of a mask */
+    void insert(const Mask& mask, size_t value) {
+        if ((entries + 1) * 2 > slots.size()) grow();
+        size_t pos = static_cast<size_t>(mask.hash()) & bitmask;
+        while (!slots[pos].empty() && !(slots[pos] == mask)) {
+            pos = (pos + 1) & bitmask;
+        }
+        if (slots[pos].empty()) ++entries;
+        slots[pos] = mask;
+        values[pos] = value;
+    }
+
+    /** @brief Number of stored masks */
+    size_t size() const { return entries; }
+
+    /** @brief Index stored for a mask, or NOT_FOUND */
+    size_t find(const Mask& mask) const {
+        size_t pos = static_cast<size_t>(mask.hash()) & bitmask;
+        while (!slots[pos].empty()) {
+            if (slots[pos] == mask) return values[pos];
+            pos = (pos + 1) & bitmask;
+        }
+        return NOT_FOUND;
+    }
+
+    bool contains(const Mask& mask) const { return find(mask) != NOT_FOUND; }
+
+private:
+    std::vector<Mask> slots;
+    std::vector<size_t> values;
+    size_t bitmask;
+    size_t numFeatures;
+    size_t entries = 0;
+
+    void grow() {
+        std::vector<Mask> oldSlots(slots.size() * 2, Mask(numFeatures));
+        std::vector<size_t> oldValues(values.size() * 2, NOT_FOUND);
+        oldSlots.swap(slots);
+        oldValues.swap(values);
+        bitmask = slots.size() - 1;
+        entries = 0;
+        for (size_t i = 0; i < oldSlots.size(); ++i) {
+            if (!oldSlots[i].empty()) insert(oldSlots[i], oldValues[i]);
+        }
+    }
+};
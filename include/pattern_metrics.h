@@ -0,0 +1,65 @@
+/**
+ * @file pattern_metrics.h
+ * @brief Prevalence measures of the candidates evaluated at one mining level
+ *
+ * The selection step computes PR, PI and WPI of every candidate once; later steps
+ * (Lemma 3 pruning of the next level, reporting) read them back instead of
+ * recounting participants from the table instances.
+ */
+
+#pragma once
+#include "types.h"
+#include <vector>
+#include <cstddef>
+
+/**
+ * @brief Prevalence measures of one evaluated candidate pattern
+ */
+struct PatternMetrics {
+    std::vector<double> participationRatios;  ///< PR(f, C) of each feature, in pattern order
+    double participationIndex = 0.0;          ///< PI(C) = min PR(f, C)
+    double weightedParticipationIndex = 0.0;  ///< WPI(C) = min PR(f, C) / RI(f, C)
+    size_t rowCount = 0;                      ///< Rows of T(C), counted whether or not the table is materialized (rows up to the abort if !exact)
+    bool prevalent = false;                   ///< WPI(C) >= min_prev
+    bool exact = true;                        ///< False if generation stopped early: PRs (and PI) are upper bounds
+};
+
+/**
+ * @brief Metrics of all candidates evaluated at one level, prevalent or not
+ *
+ * Entries keep insertion order. Lookups by pattern go through a MaskHashMap built by
+ * the consumer over patterns(), so the store itself stays independent of the mask width.
+ */
+class PatternMetricsStore {
+public:
+    /** @brief Record the metrics of an evaluated candidate */
+    void add(const Colocation& pattern, PatternMetrics metrics) {
+        patternList.push_back(pattern);
+        metricsList.push_back(std::move(metrics));
+    }
+
+    void clear() {
+        patternList.clear();
+        metricsList.clear();
+    }
+
+    size_t size() const { return patternList.size(); }
+    bool empty() const { return patternList.empty(); }
+
+    const std::vector<Colocation>& patterns() const { return patternList; }
+    const PatternMetrics& metrics(size_t index) const { return metricsList[index]; }
+    PatternMetrics& metrics(size_t index) { return metricsList[index]; }
+
+    /** @brief Prevalent patterns, in insertion order */
+    std::vector<Colocation> prevalentPatterns() const {
+        std::vector<Colocation> result;
+        for (size_t i = 0; i < patternList.size(); ++i) {
+            if (metricsList[i].prevalent) result.push_back(patternList[i]);
+        }
+        return result;
+    }
+
+private:
+    std::vector<Colocation> patternList;
+    std::vector<PatternMetrics> metricsList;
+};
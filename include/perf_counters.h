@@ -0,0 +1,96 @@
+/**
+ * @file perf_counters.h
+ * @brief Hardware performance counters (Linux perf_event_open) for stages and levels
+ *
+ * One set of counters (cycles, instructions, LLC misses, branch misses, dTLB read
+ * misses) is opened on the main thread and on every OpenMP worker thread, counting
+ * user-space events only. StageTimer reads the summed counters at both ends of a
+ * stage, so every pipeline stage and mining level reports its own deltas.
+ *
+ * Counters that cannot be opened (non-Linux systems, perf_event_paranoid, virtual
+ * machines without a PMU) are reported as unavailable and the run continues.
+ */
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/** @brief Counted hardware events */
+enum class HardwareEvent {
+    CYCLES,
+    INSTRUCTIONS,
+    LLC_MISSES,
+    BRANCH_MISSES,
+    DTLB_MISSES
+};
+
+constexpr size_t HARDWARE_EVENT_COUNT = 5;
+
+/**
+ * @brief Values of the hardware events (totals, or deltas between two reads)
+ */
+struct HardwareCounterValues {
+    std::array<uint64_t, HARDWARE_EVENT_COUNT> values{};  ///< Indexed by HardwareEvent
+    std::array<bool, HARDWARE_EVENT_COUNT> available{};   ///< Whether the event could be counted
+
+    uint64_t value(HardwareEvent event) const { return values[static_cast<size_t>(event)]; }
+    bool has(HardwareEvent event) const { return available[static_cast<size_t>(event)]; }
+
+    bool any() const {
+        for (const bool counted : available) {
+            if (counted) return true;
+        }
+        return false;
+    }
+
+    /** @brief Instructions per cycle (0 if either event is unavailable) */
+    double ipc() const {
+        if (!has(HardwareEvent::CYCLES) || !has(HardwareEvent::INSTRUCTIONS) || value(HardwareEvent::CYCLES) == 0) return 0.0;
+        return static_cast<double>(value(HardwareEvent::INSTRUCTIONS)) / value(HardwareEvent::CYCLES);
+    }
+
+    /** @brief Per-event difference this - earlier (events available in both) */
+    HardwareCounterValues since(const HardwareCounterValues& earlier) const;
+};
+
+/** @brief JSON key of an event ("cycles", "llc_misses", ...) */
+const char* hardwareEventName(HardwareEvent event);
+
+/**
+ * @brief Process-wide hardware counters
+ */
+class HardwareCounters {
+public:
+    static HardwareCounters& instance();
+
+    /**
+     * @brief Open the counters on the calling thread and on every OpenMP thread
+     *
+     * Call before the first parallel region so the OpenMP worker threads exist and are
+     * reused afterwards. Prints one warning if some events are unavailable.
+     */
+    void open();
+
+    /** @brief Whether at least one event is being counted */
+    bool active() const { return opened; }
+
+    /** @brief Current totals, summed over all counted threads (scaled if multiplexed) */
+    HardwareCounterValues read() const;
+
+    ~HardwareCounters();
+
+private:
+    HardwareCounters() = default;
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+    std::mutex fdMutex;
+    std::vector<std::array<int, HARDWARE_EVENT_COUNT>> threadFds;  ///< -1: event not counted
+    bool opened = false;
+
+    void openForThisThread();
+};
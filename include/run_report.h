@@ -0,0 +1,110 @@
+/**
+ * @file run_report.h
+ * @brief Machine-readable performance report of one run (JSON)
+ *
+ * Every pipeline stage (load, grid join, neighborhood build, NR-tree build, mining)
+ * and every mining level records wall time, CPU time, page faults and context switches,
+ * and the process RSS high-water mark with how far the stage raised it (see
+ * telemetry.h), plus hardware events and heap allocation traffic when those are enabled
+ * (perf_counters.h, alloc_tracker.h); mining levels add their candidate, table and
+ * prevalence counts, and a sampled RSS timeline spans the whole run. The report is
+ * written as one JSON object so runs can be compared by scripts.
+ */
+
+#pragma once
+#include "telemetry.h"
+#include "perf_counters.h"
+#include "alloc_tracker.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Resources used by one pipeline stage
+ */
+struct StageStats {
+    std::string name;                       ///< Stage name (e.g. "load", "grid_join")
+    double wallSeconds = 0;                 ///< Elapsed wall-clock time
+    double cpuSeconds = 0;                  ///< Process CPU time (all threads)
+    double processPeakRSSMB = 0;            ///< High-water mark of the process RSS at the end of the stage (covers all earlier stages)
+    double peakRSSGrowthMB = 0;             ///< How far the stage raised that high-water mark (0 if it stayed below an earlier peak)
+    int64_t minorFaults = 0;                ///< Minor page faults during the stage
+    int64_t majorFaults = 0;                ///< Major page faults during the stage
+    int64_t voluntaryContextSwitches = 0;   ///< Voluntary context switches during the stage
+    int64_t involuntaryContextSwitches = 0; ///< Involuntary context switches during the stage
+    HardwareCounterValues counters;         ///< Hardware events during the stage (if counters are open)
+    AllocationStats allocations;            ///< Heap allocations during the stage (if the tracker is enabled)
+};
+
+/**
+ * @brief Counts and resources of one mining level (all patterns of one size)
+ */
+struct LevelStats {
+    size_t patternSize = 0;  ///< k
+    size_t candidates = 0;   ///< Generated size-k candidates
+    size_t filtered = 0;     ///< Candidates left after Lemma 2 / Lemma 3 pruning
+    size_t tableRows = 0;    ///< Table instance rows generated for the filtered candidates
+    size_t prevalent = 0;    ///< Prevalent size-k patterns
+    size_t bytesHeld = 0;    ///< Bytes of the tables kept in memory for the next level
+    size_t peakBytesHeld = 0;///< Most bytes of tables kept in memory while the level was generated
+    size_t arenaBytes = 0;   ///< Bytes the level arena took from the heap (extension sets)
+    size_t spilledTables = 0;///< Tables written to disk to stay within the memory budget
+    size_t spilledBytes = 0; ///< Bytes written to disk for them
+    StageStats resources;    ///< Time, memory and OS counters of the level
+};
+
+/**
+ * @brief Measures wall time and resource counters from construction to stop()
+ *
+ * Holds an allocation peak window while alive, so it is neither copied nor moved.
+ */
+class StageTimer {
+public:
+    StageTimer();
+
+    /** @brief Resources used since construction, under the given stage name */
+    StageStats stop(const std::string& name) const;
+
+    std::chrono::high_resolution_clock::time_point startTime() const { return wallStart; }
+
+private:
+    std::chrono::high_resolution_clock::time_point wallStart;
+    ResourceUsage usageStart;
+    HardwareCounterValues countersStart;
+    AllocationStats allocationsStart;
+    AllocationPeakWindow allocationPeak;
+};
+
+/**
+ * @brief Run description, stage resources and mining levels, written as JSON
+ */
+class RunReport {
+public:
+    /** @brief Add a top-level string field */
+    void setText(const std::string& key, const std::string& value);
+
+    /** @brief Add a top-level numeric field */
+    void setNumber(const std::string& key, double value);
+
+    void addStage(const StageStats& stage) { stageList.push_back(stage); }
+    void setLevels(const std::vector<LevelStats>& levels) { levelList = levels; }
+    void setTimeline(const std::vector<MemorySample>& timeline) { memoryTimeline = timeline; }
+
+    const std::vector<StageStats>& stages() const { return stageList; }
+    const std::vector<LevelStats>& levels() const { return levelList; }
+
+    /**
+     * @brief Write the report to a file
+     * @return false if the file cannot be written
+     */
+    bool writeJson(const std::string& path) const;
+
+private:
+    std::vector<std::pair<std::string, std::string>> fields; ///< Key -> JSON literal
+    std::vector<StageStats> stageList;
+    std::vector<LevelStats> levelList;
+    std::vector<MemorySample> memoryTimeline;
+};
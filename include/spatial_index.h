@@ -5,17 +5,29 @@
 
 #pragma once
 #include "types.h"
+#include "constants.h"
 #include <vector>
 
 /**
  * @brief SpatialIndex class for managing spatial indexing and neighbor searches
  * 
  * Provides functionality to find neighboring spatial instances within a distance threshold.
- * Currently uses a brute-force O(n²) approach for neighbor pair detection.
+ * Uses a uniform grid whose cells are the size of the distance threshold. Cells that hold
+ * more points than the split threshold (hotspots) are refined adaptively into a quadtree,
+ * so dense regions are joined node-against-node instead of point-against-point.
+ * 
+ * In geodesic mode, longitude/latitude points are projected onto a local plane whose
+ * distances provably never exceed the great-circle distance of pairs within the
+ * threshold, the grid is built on that plane,
+ * and candidates are confirmed with the exact great-circle distance. Pairs that are
+ * closer the other way round the globe (across the seam of the projection) are found
+ * by joining the two strips along the seam.
  */
 class SpatialIndex {
 private:
-    double distanceThreshold;  ///< Distance threshold for neighbor determination
+    double distanceThreshold;   ///< Distance threshold for neighbor determination
+    size_t cellSplitThreshold;  ///< Maximum occupancy of a grid cell or quadtree leaf before it is subdivided
+    CoordinateSystem coordinateSystem;  ///< How instance coordinates and the threshold are interpreted
 
     /**
      * @brief Calculate Euclidean distance between two spatial instances
@@ -25,24 +37,56 @@ private:
      * @return double Euclidean distance between a and b
      */
     double euclideanDist(const SpatialInstance& a, const SpatialInstance& b) const;
+
+    /**
+     * @brief Project instances onto the plane used for grid bucketing
+     * 
+     * Planar mode returns the coordinates unchanged. Geodesic mode uses an
+     * equirectangular projection whose x axis is scaled by cos(max|lat| + threshold / R),
+     * the smallest cos(latitude) any great-circle path between two neighbors can reach.
+     * Projected distances are then a lower bound of great-circle distances for neighbor
+     * pairs that do not cross the seam of the projection. When that latitude reaches a
+     * pole, longitude is dropped (x = 0) and the grid degenerates to latitude bands.
+     * The reference longitude is the centre of
+     * the smallest arc covering all longitudes, so the seam lies in the widest gap of
+     * the data (data crossing the antimeridian is not split).
+     * 
+     * @param instances Vector of all spatial instances
+     * @param gridX Output projected x coordinate per instance
+     * @param gridY Output projected y coordinate per instance
+     * @return Projected width of 360° of longitude (geodesic), or 0 (planar)
+     */
+    double projectToGrid(const std::vector<SpatialInstance>& instances,
+                         std::vector<double>& gridX, std::vector<double>& gridY) const;
     
 public:
     /**
      * @brief Constructor to initialize SpatialIndex with a distance threshold
      * 
      * @param distThresh Maximum distance for two instances to be considered neighbors
+     * @param cellSplitThresh Occupancy above which a grid cell is refined into a quadtree
+     * @param coordSystem Coordinate system of the instances (distThresh is in meters for GEODESIC)
      */
-    explicit SpatialIndex(double distThresh);
+    explicit SpatialIndex(double distThresh,
+                          size_t cellSplitThresh = Constants::DEFAULT_CELL_SPLIT_THRESHOLD,
+                          CoordinateSystem coordSystem = CoordinateSystem::PLANAR);
 
     /**
      * @brief Find all neighbor pairs within the distance threshold
      * 
-     * Uses brute-force comparison (O(n²)) to find all pairs of instances
-     * that are within the specified distance threshold.
+     * Buckets instances into a grid of threshold-sized cells and joins every cell with
+     * itself and its forward neighbors. Hot cells are subdivided into quadtrees until
+     * leaf occupancy drops under the split threshold; node pairs whose bounding boxes
+     * are farther apart than the threshold are skipped and node pairs whose boxes fit
+     * entirely within the threshold are emitted without per-pair distance checks.
+     * Heavy cell pairs are split into independent tasks that run in parallel (OpenMP).
+     * In geodesic mode the wholesale shortcut is disabled and leaf pairs are confirmed
+     * with a vectorized great-circle kernel on precomputed unit vectors (no per-pair
+     * trigonometry).
      * 
      * @param instances Vector of all spatial instances to search
      * @return std::vector<std::pair<SpatialInstance, SpatialInstance>> Vector of neighbor pairs
-     * @note Time complexity: O(n²) where n is the number of instances
+     * @note Results are exact: every pair at distance <= threshold is reported exactly once
      */
     std::vector<std::pair<SpatialInstance, SpatialInstance>> findNeighborPair(const std::vector<SpatialInstance>& instances) const;
-};
\ No newline at end of file
+};
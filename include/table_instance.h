@@ -0,0 +1,162 @@
+/**
+ * @file table_instance.h
+ * @brief Table instances stored as packed rows of instance ordinals
+ *
+ * Position i of a row of T(C) always holds an instance of feature C[i], so a row only
+ * needs the instance ordinals: K uint32_t values, stored contiguously with all other
+ * rows of the table (4K bytes per row instead of a heap-allocated pointer vector).
+ * TableInstance<K> fixes the row width at compile time for K = 2..MAX_FIXED_ROW_WIDTH
+ * so row copies and loops over positions unroll; TableInstance<DYNAMIC_ROW_WIDTH>
+ * carries the width at runtime. The miner keeps its tables as PackedTable and selects
+ * the fixed-width kernel of a level through dispatchRowWidth.
+ *
+ * Rows are stored in a std::pmr::vector, so a table can live in a level arena; moving a
+ * table keeps its memory resource.
+ */
+
+#pragma once
+#include "types.h"
+#include "NRTree.h"
+#include "constants.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** @brief Row width of a TableInstance whose width is only known at runtime */
+constexpr size_t DYNAMIC_ROW_WIDTH = 0;
+
+/**
+ * @brief Table instance with rows of K instance ordinals
+ */
+template <size_t K>
+class TableInstance {
+public:
+    using Storage = std::pmr::vector<uint32_t>;
+
+    /** @brief Create an empty table (width is only checked by the dynamic variant) */
+    explicit TableInstance(size_t width = K, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : ordinals(resource) { (void)width; }
+
+    size_t width() const { return K; }
+    size_t size() const { return ordinals.size() / K; }
+    bool empty() const { return ordinals.empty(); }
+
+    /** @brief Ordinals of row r (K values) */
+    const uint32_t* row(size_t r) const { return ordinals.data() + r * K; }
+
+    void reserve(size_t rows) { ordinals.reserve(rows * K); }
+
+    /** @brief Append a complete row */
+    void push_back(const uint32_t* row) { ordinals.insert(ordinals.end(), row, row + K); }
+
+    /** @brief Append a prefix row (K-1 ordinals) extended by the ordinal of one more instance */
+    void pushExtended(const uint32_t* prefixRow, uint32_t ordinal) {
+        const size_t offset = ordinals.size();
+        ordinals.resize(offset + K);
+        std::copy_n(prefixRow, K - 1, ordinals.data() + offset);
+        ordinals[offset + K - 1] = ordinal;
+    }
+
+    /** @brief Drop all rows and give their storage back to the memory resource */
+    void release() { Storage(ordinals.get_allocator()).swap(ordinals); }
+
+    /** @brief Row-major ordinals of all rows */
+    const Storage& data() const { return ordinals; }
+    Storage& data() { return ordinals; }
+
+    /** @brief Heap bytes held by the rows */
+    size_t memoryBytes() const { return ordinals.capacity() * sizeof(uint32_t); }
+
+private:
+    Storage ordinals;
+};
+
+/**
+ * @brief Table instance whose row width is chosen at runtime (fallback for wide patterns)
+ */
+template <>
+class TableInstance<DYNAMIC_ROW_WIDTH> {
+public:
+    using Storage = std::pmr::vector<uint32_t>;
+
+    explicit TableInstance(size_t width = 0, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : rowWidth(width), ordinals(resource) {}
+
+    /** @brief Take over the rows of a fixed-width table without copying them */
+    template <size_t K>
+    TableInstance(TableInstance<K>&& fixed) : rowWidth(K), ordinals(std::move(fixed.data())) {}
+
+    size_t width() const { return rowWidth; }
+    size_t size() const { return rowWidth ? ordinals.size() / rowWidth : 0; }
+    bool empty() const { return ordinals.empty(); }
+
+    const uint32_t* row(size_t r) const { return ordinals.data() + r * rowWidth; }
+
+    void reserve(size_t rows) { ordinals.reserve(rows * rowWidth); }
+
+    void push_back(const uint32_t* row) { ordinals.insert(ordinals.end(), row, row + rowWidth); }
+
+    void pushExtended(const uint32_t* prefixRow, uint32_t ordinal) {
+        ordinals.insert(ordinals.end(), prefixRow, prefixRow + rowWidth - 1);
+        ordinals.push_back(ordinal);
+    }
+
+    void release() { Storage(ordinals.get_allocator()).swap(ordinals); }
+
+    const Storage& data() const { return ordinals; }
+    Storage& data() { return ordinals; }
+
+    size_t memoryBytes() const { return ordinals.capacity() * sizeof(uint32_t); }
+
+private:
+    size_t rowWidth;
+    Storage ordinals;
+};
+
+/** @brief Table instance type the miner stores tables in */
+using PackedTable = TableInstance<DYNAMIC_ROW_WIDTH>;
+
+/**
+ * @brief Call fn with std::integral_constant<size_t, K> for the given row width
+ *
+ * Widths 2..MAX_FIXED_ROW_WIDTH get their fixed-width specialization, every other
+ * width DYNAMIC_ROW_WIDTH.
+ */
+template <typename Fn>
+void dispatchRowWidth(size_t width, Fn&& fn) {
+    static_assert(Constants::MAX_FIXED_ROW_WIDTH == 8, "dispatchRowWidth lists widths 2..8");
+    switch (width) {
+    case 2: fn(std::integral_constant<size_t, 2>()); break;
+    case 3: fn(std::integral_constant<size_t, 3>()); break;
+    case 4: fn(std::integral_constant<size_t, 4>()); break;
+    case 5: fn(std::integral_constant<size_t, 5>()); break;
+    case 6: fn(std::integral_constant<size_t, 6>()); break;
+    case 7: fn(std::integral_constant<size_t, 7>()); break;
+    case 8: fn(std::integral_constant<size_t, 8>()); break;
+    default: fn(std::integral_constant<size_t, DYNAMIC_ROW_WIDTH>()); break;
+    }
+}
+
+/**
+ * @brief Maps (feature, ordinal) back to the spatial instance
+ *
+ * Built from the NR-tree (star centers and their neighbors), which holds every instance
+ * that can appear in a table instance row.
+ */
+class InstanceLookup {
+public:
+    InstanceLookup() = default;
+    explicit InstanceLookup(const NRTree& orderedNRTree);
+
+    /** @brief Instance of the given feature with the given ordinal (nullptr if unknown) */
+    const SpatialInstance* find(const FeatureType& feature, uint32_t ordinal) const;
+
+private:
+    std::unordered_map<FeatureType, std::vector<const SpatialInstance*>> byOrdinal;
+    void add(const SpatialInstance* instance);
+};
@@ -0,0 +1,65 @@
+/**
+ * @file table_spill.h
+ * @brief Spilling of table instances to temporary files under a memory budget
+ */
+
+#pragma once
+#include "types.h"
+#include "table_instance.h"
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Table instances of one level written to an anonymous temporary file
+ * 
+ * Packed rows are written as they are (k uint32_t ordinals, row[i] is an instance of
+ * pattern[i]), so a row costs 4k bytes on disk. The file is removed automatically when
+ * the object is destroyed. spill() and load() may be called from several threads.
+ */
+class SpilledTables {
+public:
+    SpilledTables();
+    ~SpilledTables();
+
+    SpilledTables(const SpilledTables&) = delete;
+    SpilledTables& operator=(const SpilledTables&) = delete;
+
+    /** @brief Append the rows of a pattern to the file; returns false on I/O failure */
+    bool spill(const Colocation& pattern, const PackedTable& rows);
+
+    /** @brief Whether the table of the pattern was spilled */
+    bool contains(const Colocation& pattern) const { return entries.count(pattern) != 0; }
+
+    /**
+     * @brief Read the rows of a spilled pattern back
+     * 
+     * Throws std::runtime_error if the rows cannot be read (the run cannot continue
+     * without them) and std::logic_error if the pattern was not spilled.
+     */
+    PackedTable load(const Colocation& pattern) const;
+
+    /** @brief Number of spilled tables */
+    size_t size() const { return entries.size(); }
+
+    /** @brief Bytes written to the file */
+    size_t bytesWritten() const { return static_cast<size_t>(endOffset); }
+
+private:
+    struct Entry {
+        int64_t offset;  ///< Byte offset of the first row
+        size_t rowCount; ///< Number of rows
+    };
+
+    std::FILE* file;
+    int64_t endOffset = 0;
+    std::map<Colocation, Entry> entries;
+    mutable std::mutex fileMutex;
+};
+
+/**
+ * @brief Approximate heap bytes held by a table instance and its extension sets
+ */
+size_t estimateTableBytes(const PackedTable& rows, const ExtensionTable* extensions);
@@ -0,0 +1,88 @@
+/**
+ * @file telemetry.h
+ * @brief Portable process resource telemetry (memory, CPU, page faults, context switches)
+ *
+ * On Linux, current and peak RSS are read from /proc/self/status (VmRSS, VmHWM) and
+ * CPU time, page faults and context switches from getrusage. Other POSIX systems use
+ * getrusage only (no current RSS), and Windows uses GetProcessMemoryInfo and
+ * GetProcessTimes (no major faults or context switches).
+ */
+
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Resource counters of the process at one point in time
+ *
+ * Counters that are not available on the platform stay 0.
+ */
+struct ResourceUsage {
+    double currentRSSMB = 0;                 ///< Resident set size
+    double peakRSSMB = 0;                    ///< Peak resident set size since process start
+    double userCpuSeconds = 0;               ///< User CPU time of all threads
+    double systemCpuSeconds = 0;             ///< System CPU time of all threads
+    int64_t minorFaults = 0;                 ///< Page faults served without I/O
+    int64_t majorFaults = 0;                 ///< Page faults that required I/O
+    int64_t voluntaryContextSwitches = 0;    ///< Waits (I/O, locks, sleeps)
+    int64_t involuntaryContextSwitches = 0;  ///< Preemptions
+
+    double cpuSeconds() const { return userCpuSeconds + systemCpuSeconds; }
+};
+
+/**
+ * @brief Read the current resource counters of the process
+ */
+ResourceUsage sampleResourceUsage();
+
+/**
+ * @brief One point of the memory timeline
+ */
+struct MemorySample {
+    double seconds = 0;    ///< Time since the sampler was started
+    double rssMB = 0;      ///< Resident set size
+    std::string stage;     ///< Pipeline stage running when the sample was taken
+};
+
+/**
+ * @brief Background thread that records the RSS of the process at a fixed interval
+ *
+ * The caller labels the timeline with setStage() when a pipeline stage begins. Stopping
+ * (explicitly or on destruction) records a final sample.
+ */
+class MemorySampler {
+public:
+    MemorySampler() = default;
+    ~MemorySampler();
+
+    MemorySampler(const MemorySampler&) = delete;
+    MemorySampler& operator=(const MemorySampler&) = delete;
+
+    /** @brief Start sampling every intervalMs milliseconds (0: do not sample) */
+    void start(unsigned intervalMs);
+
+    /** @brief Stop the sampling thread */
+    void stop();
+
+    /** @brief Label of the samples taken from now on; also records a sample */
+    void setStage(const std::string& stage);
+
+    /** @brief Samples recorded so far */
+    std::vector<MemorySample> timeline() const;
+
+private:
+    std::thread worker;
+    mutable std::mutex sampleMutex;
+    std::condition_variable stopSignal;
+    bool running = false;
+    std::chrono::steady_clock::time_point startTime;
+    std::string currentStage;
+    std::vector<MemorySample> samples;
+
+    void record();  // Requires sampleMutex
+};
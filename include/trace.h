@@ -0,0 +1,101 @@
+/**
+ * @file trace.h
+ * @brief Chrome / Perfetto trace-event output of scoped spans
+ *
+ * TRACE_SCOPE(name) records a complete event ("ph": "X") from its position to the end
+ * of the enclosing scope, on the calling thread. Events are buffered per thread and
+ * written by Tracer::finish() as a trace.json that chrome://tracing and
+ * ui.perfetto.dev open directly.
+ *
+ * Tracing is opt-in twice: the macro only expands when the build defines ENABLE_TRACING
+ * (CMake option of the same name), and a traced build only records after
+ * Tracer::start(). Without ENABLE_TRACING, TRACE_SCOPE and its name expression compile
+ * to nothing.
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Process-wide collector of trace events
+ */
+class Tracer {
+public:
+    static Tracer& instance();
+
+    /** @brief Start recording; events are written to path by finish() */
+    void start(const std::string& path);
+
+    /**
+     * @brief Stop recording and write the trace file
+     * @return false if the file cannot be written (or tracing was not started)
+     */
+    bool finish();
+
+    /** @brief Whether spans are being recorded */
+    static bool active() { return enabled.load(std::memory_order_relaxed); }
+
+    /** @brief Record a span of the calling thread */
+    void record(std::string name, std::chrono::steady_clock::time_point begin,
+        std::chrono::steady_clock::time_point end);
+
+private:
+    struct Event {
+        std::string name;
+        double beginUs;     ///< Microseconds since start()
+        double durationUs;
+    };
+    struct ThreadBuffer {
+        uint32_t tid;       ///< Small sequential id in order of the first recorded span
+        std::vector<Event> events;
+    };
+
+    Tracer() = default;
+    ThreadBuffer& threadBuffer();
+
+    static std::atomic<bool> enabled;
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;  // Never freed: threads keep pointers
+    std::string outputPath;
+    std::chrono::steady_clock::time_point origin;
+};
+
+/**
+ * @brief Span from construction to destruction (use TRACE_SCOPE)
+ */
+class TraceScope {
+public:
+    explicit TraceScope(std::string name)
+        : name(std::move(name)), recording(Tracer::active()) {
+        if (recording) begin = std::chrono::steady_clock::now();
+    }
+
+    ~TraceScope() {
+        if (recording) Tracer::instance().record(std::move(name), begin, std::chrono::steady_clock::now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    std::string name;
+    bool recording;
+    std::chrono::steady_clock::time_point begin;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_TRACING
+// The name expression is only evaluated while a trace is being recorded
+#define TRACE_SCOPE(name) \
+    TraceScope TRACE_CONCAT(traceScope, __LINE__)(Tracer::active() ? std::string(name) : std::string())
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#endif
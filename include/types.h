@@ -11,6 +11,8 @@
 #include <unordered_map>
 #include <vector>
 #include <map>
+#include <memory_resource>
+#include <cstdint>
 
 // ============================================================================
 // Type Aliases
@@ -28,6 +30,29 @@ using Colocation = std::vector<FeatureType>;
 /** @brief Type alias for a colocation instance (set of spatial instance pointers) */
 using ColocationInstance = std::vector<const struct SpatialInstance*>;
 
+/**
+ * @brief Coordinate system of the input dataset
+ * 
+ * PLANAR: LocX/LocY are Cartesian coordinates, distances are Euclidean.
+ * GEODESIC: LocX is longitude and LocY is latitude in degrees, distances are
+ * great-circle distances in meters.
+ */
+enum class CoordinateSystem {
+    PLANAR,
+    GEODESIC
+};
+
+/**
+ * @brief Search order of the miner
+ * 
+ * LEVEL_WISE: all size-k patterns before any size-(k+1) pattern (keeps one level of tables).
+ * DEPTH_FIRST: prefix by prefix through the pattern lattice (keeps the tables of one path).
+ */
+enum class MiningStrategy {
+    LEVEL_WISE,
+    DEPTH_FIRST
+};
+
 // ============================================================================
 // Data Structures
 // ============================================================================
@@ -36,11 +61,14 @@ using ColocationInstance = std::vector<const struct SpatialInstance*>;
  * @brief Structure representing a spatial data instance
  * 
  * Each spatial instance has a feature type, unique identifier, and 2D coordinates.
+ * The ordinal numbers the instances of one feature densely (0 .. count-1) in load
+ * order, so per-feature bitmaps and arrays can be indexed by it.
  */
 struct SpatialInstance {
-    FeatureType type;  ///< Feature type of this instance (e.g., "A", "B")
-    instanceID id;     ///< Unique identifier (e.g., "A1", "B2")
-    double x, y;       ///< 2D spatial coordinates
+    FeatureType type;      ///< Feature type of this instance (e.g., "A", "B")
+    instanceID id;         ///< Unique identifier (e.g., "A1", "B2")
+    double x, y;           ///< 2D spatial coordinates
+    uint32_t ordinal = 0;  ///< Dense index among the instances of the same feature type
 };
 
 /**
@@ -52,4 +80,26 @@ struct SpatialInstance {
 struct OrderedNeigh {
     const SpatialInstance* center;                      ///< Center instance
     std::unordered_map<FeatureType, std::vector<const SpatialInstance*>> neighbors;      ///< All neighbors within distance threshold
-};
\ No newline at end of file
+};
+
+/**
+ * @brief Candidate extension sets S(I, f) carried with the rows of one table instance
+ * 
+ * S(I, f) = Neigh(o1, f) ∩ ... ∩ Neigh(ok, f) is the set of instances of feature f that
+ * extend row I. Carrying it lets the next level compute S(I ∪ {o}, f) = S(I, f) ∩ Neigh(o, f)
+ * with one intersection instead of k.
+ * 
+ * features lists the extension features kept for the pattern (in feature order) and
+ * sets[r][j] is S(row r, features[j]), sorted by instance ordinal. The sets are
+ * allocated from the memory resource the table is created with (the level arena of the
+ * level-wise miner, see level_arena.h); rows and sets added later use the same resource.
+ */
+struct ExtensionTable {
+    using InstanceSet = std::pmr::vector<const SpatialInstance*>;
+
+    std::vector<FeatureType> features;                   ///< Extension features kept for this pattern
+    std::pmr::vector<std::pmr::vector<InstanceSet>> sets; ///< Per row, per kept feature: S(I, f)
+
+    ExtensionTable() = default;
+    explicit ExtensionTable(std::pmr::memory_resource* resource) : sets(resource) {}
+};
@@ -11,6 +11,30 @@
 #include <chrono>
 #include <map>
 #include <optional>
+#include <cstdint>
+
+/**
+ * @brief Bitmap over the instances of one feature, indexed by instance ordinal
+ * 
+ * Used to count distinct participating instances (the numerator of PR) without
+ * building sets of instance IDs.
+ */
+class InstanceBitmap {
+public:
+    explicit InstanceBitmap(size_t numInstances = 0) : words((numInstances + 63) / 64, 0) {}
+
+    /** @brief Mark the instance with the given ordinal as participating */
+    void set(uint32_t ordinal) { words[ordinal >> 6] |= (uint64_t{ 1 } << (ordinal & 63)); }
+
+    /** @brief Check whether the instance with the given ordinal participates */
+    bool test(uint32_t ordinal) const { return (words[ordinal >> 6] >> (ordinal & 63)) & 1; }
+
+    /** @brief Number of participating instances */
+    size_t count() const;
+
+private:
+    std::vector<uint64_t> words;
+};
 
 /**
  * @brief Get all unique feature types from spatial instances
@@ -26,7 +50,8 @@ std::vector<FeatureType> getAllObjectTypes(const std::vector<SpatialInstance>& i
 /**
  * @brief Count the number of instances for each feature type
  * 
- * Creates a frequency map showing how many instances exist for each feature type.
+ * Creates a frequency map showing how many instances exist for each feature type
+ * (taken from SpatialInstance::type, so feature names may have any length).
  * 
  * @param instances Vector of spatial instances
  * @return std::map<FeatureType, int> Map from feature type to instance count
@@ -47,17 +72,23 @@ std::optional<SpatialInstance> getInstanceByID(
     const instanceID& id);
 
 /**
- * @brief Sort features by instance count (ascending)
- * @param featureSet The feature set to sort
- * @param instances The instances used to count feature frequency
+ * @brief Feature order used throughout mining: ascending instance count, ties by name
+ * 
+ * @param a First feature type
+ * @param b Second feature type
+ * @param featureCounts Map of instance counts for all features (missing features count as 0)
+ * @return bool True if a comes before b
  */
-std::vector<FeatureType> featureSort(const std::vector<FeatureType>& featureSet, const std::vector<SpatialInstance>& instances);
+bool featureLess(const FeatureType& a, const FeatureType& b, const std::map<FeatureType, int>& featureCounts);
 
 double calculateDelta(const std::vector<FeatureType>& sortedFeatures, const std::map<FeatureType, int>& featureCounts);
 
 /**
  * @brief Calculate Participation Ratio (PR) for a feature in a co-location
  * 
+ * Reference implementation of the definition on a map of pointer-row tables; the miner
+ * counts PR in packed tables with instance bitmaps instead and does not call it.
+ * 
  * @param featureType The feature type to calculate PR for
  * @param pattern The co-location pattern
  * @param tableInstance The table instance T(C) of the pattern
@@ -84,11 +115,73 @@ double calculateRareIntensity(
     const std::map<FeatureType, int>& featureCounts,
     double delta);
 
+/**
+ * @brief Dense table of WPI weights 1 / RI(f, C) indexed by feature rank
+ * 
+ * RI(f, C) only depends on num(f), num(f_min of C) and delta, so the weight of every
+ * (feature, f_min) pair is computed once after calculateDelta. Features are addressed by
+ * their position in the sorted feature list; in a feature-ordered pattern f_min is the
+ * first feature. A weight of 0 means RI is (numerically) zero, as in the WPI definition.
+ */
+class RareWeightTable {
+public:
+    RareWeightTable() = default;
+
+    /**
+     * @param sortedFeatures Features in feature order (defines the ranks)
+     * @param featureCounts Map of instance counts for all features
+     * @param delta Global degree of dispersion
+     */
+    RareWeightTable(
+        const std::vector<FeatureType>& sortedFeatures,
+        const std::map<FeatureType, int>& featureCounts,
+        double delta);
+
+    /** @brief Whether the table was built from these features, counts and delta */
+    bool builtFrom(
+        const std::vector<FeatureType>& sortedFeatures,
+        const std::map<FeatureType, int>& featureCounts,
+        double delta) const;
+
+    /** @brief Number of features (the table is size() x size()) */
+    size_t size() const { return numFeatures; }
+
+    /** @brief 1 / RI(f, C) for the feature of rank featureRank in a pattern whose f_min has rank minRank */
+    double weight(size_t featureRank, size_t minRank) const { return weights[featureRank * numFeatures + minRank]; }
+
+    /**
+     * @brief WPI of a whole level of size-k patterns: min over j of PR_j * weight(rank_j, rank_0)
+     * 
+     * @param ranks Feature ranks of all patterns, row-major (patterns x patternSize)
+     * @param participationRatios PRs in the same layout
+     * @param patternSize k
+     * @param wpi Output: one WPI per pattern
+     */
+    void levelWPI(
+        const std::vector<uint32_t>& ranks,
+        const std::vector<double>& participationRatios,
+        size_t patternSize,
+        std::vector<double>& wpi) const;
+
+private:
+    size_t numFeatures = 0;
+    std::vector<double> weights;  ///< weights[f * numFeatures + fmin]
+    std::vector<FeatureType> rankedFeatures;  ///< Features the table was built from, in rank order
+    std::vector<int> counts;                  ///< Instance count per rank
+    double sourceDelta = 0.0;                 ///< Delta the table was built with
+
+    static std::vector<int> rankedCounts(
+        const std::vector<FeatureType>& sortedFeatures,
+        const std::map<FeatureType, int>& featureCounts);
+};
+
 /**
  * @brief Calculate Participation Index (PI) of a co-location pattern
  * 
  * PI(C) = min(PR(fi, C)) for all fi in C
  * 
+ * Reference implementation on top of calculatePR (not called by the miner).
+ * 
  * @param pattern The co-location pattern
  * @param tableInstance The table instance T(C) of the pattern
  * @param featureCounts Map of instance counts for all features
@@ -98,6 +191,45 @@ double calculatePI(
     const Colocation& pattern,
     const std::map<Colocation, std::vector<ColocationInstance>>& tableInstance,
     const std::map<FeatureType, int>& featureCounts);
+/**
+ * @brief Intersect two instance lists sorted by ordinal
+ * 
+ * Both lists must hold instances of the same feature type, so the ordinal identifies
+ * an instance. Runs as a linear merge.
+ * 
+ * @param a First list, sorted by ordinal
+ * @param b Second list, sorted by ordinal
+ * @return std::vector<const SpatialInstance*> Instances present in both lists (sorted by ordinal)
+ */
+std::vector<const SpatialInstance*> intersectByOrdinal(
+    const std::vector<const SpatialInstance*>& a,
+    const std::vector<const SpatialInstance*>& b);
+
+/**
+ * @brief Intersect two instance lists sorted by ordinal into an extension set
+ * 
+ * Same merge as above. Matches are gathered in a per-thread buffer and copied once, so
+ * out gets exactly the size of the intersection from its own memory resource (a level
+ * arena does not reclaim over-reserved space).
+ */
+template <typename ListA, typename ListB>
+void intersectByOrdinal(const ListA& a, const ListB& b, ExtensionTable::InstanceSet& out) {
+    thread_local std::vector<const SpatialInstance*> matches;
+    matches.clear();
+
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i]->ordinal < b[j]->ordinal) ++i;
+        else if (b[j]->ordinal < a[i]->ordinal) ++j;
+        else {
+            matches.push_back(a[i]);
+            ++i;
+            ++j;
+        }
+    }
+    out.assign(matches.begin(), matches.end());
+}
+
 /**
 * @brief Recursive helper to find all combinations of spatial instances
 *        matching a candidate pattern within a star neighborhood.
@@ -116,6 +248,12 @@ void findCombinations(
     std::vector<ColocationInstance>& results);
 
 
+/**
+ * @brief Readable name of a pattern, e.g. "{A, B, C}" (trace spans and check output)
+ */
+std::string patternName(const Colocation& pattern);
+
+
 /**
 * @brief Print the duration of a processing step
 * 
@@ -125,12 +263,3 @@ void findCombinations(
 */
 void printDuration(const std::string& stepName, std::chrono::high_resolution_clock::time_point start, std::chrono::high_resolution_clock::time_point end);
 
-
-/**
- * @brief Get current memory usage in megabytes
- *
- * Uses Windows API to retrieve the current process's memory usage.
- *
- * @return double Memory usage in MB
- */
-double getMemoryUsageMB();
\ No newline at end of file
@@ -1,5 +1,6 @@
 ﻿#include "NRTree.h"
 #include "utils.h"
+#include "trace.h"
 
 NRTree::NRTree() {
     root = new NRNode(ROOT_NODE);
@@ -12,23 +13,23 @@ NRTree::~NRTree() {
     }
 }
 
-void NRTree::build(const NeighborhoodMgr& neighMgr, const std::map<FeatureType, int>& featureCounts, const std::vector<SpatialInstance>& instances) {
+void NRTree::build(const NeighborhoodMgr& neighMgr, const FeatureRanking& ranking) {
+    TRACE_SCOPE("NRTree::build");
     // 0. Reset tree if old data exists
     if (root) delete root;
     root = new NRNode(ROOT_NODE);
+    starIndex.clear();
 
     // Get raw map data: unordered_map<FeatureType, vector<OrderedNeigh>>
     const auto& rawMap = neighMgr.getOrderedNeighbors();
 
     // 1. LEVEL 1: FEATURE NODES
     // According to paper: Features must be sorted by instance count (ascending order)
-    // Same logic as in isOrdered() and featureSort()
+    // Same logic as in isOrdered(): the ranking is already in that order
     std::vector<FeatureType> sortedFeatures;
-    for (const auto& pair : rawMap) {
-        sortedFeatures.push_back(pair.first);
+    for (const auto& fType : ranking.features()) {
+        if (rawMap.count(fType)) sortedFeatures.push_back(fType);
     }
-    //Sort features by feature count (ascending)
-    sortedFeatures = featureSort(sortedFeatures, instances);
 
     for (const auto& fType : sortedFeatures) {
         // Create feature node (e.g., Node A)
@@ -38,12 +39,16 @@ void NRTree::build(const NeighborhoodMgr& neighMgr, const std::map<FeatureType,
 
         // Get list of center instances for this feature
         const auto& starList = rawMap.at(fType);
+        auto& featureStars = starIndex[fType];
+        featureStars.assign(ranking.count(fType), nullptr);
 
         // 2. LEVEL 2: INSTANCE NODES (Center)
         for (const auto& star : starList) {
             NRNode* centerNode = new NRNode(INSTANCE_NODE);
             centerNode->data = star.center; // Store pointer to original data
             fNode->children.push_back(centerNode);
+            if (star.center->ordinal >= featureStars.size()) featureStars.resize(star.center->ordinal + 1, nullptr);
+            featureStars[star.center->ordinal] = centerNode;
 
             // 3. LEVEL 3: FEATURE NODES (for neighbor features)
             // Neighbor data is in: star.neighbors (unordered_map<FeatureType, vector<const SpatialInstance*>>)
@@ -55,7 +60,7 @@ void NRTree::build(const NeighborhoodMgr& neighMgr, const std::map<FeatureType,
                 neighborFeatureTypes.push_back(mapEntry.first);
             }
             // Sort neighbor feature types by feature count (ascending)
-            neighborFeatureTypes = featureSort(neighborFeatureTypes, instances);
+            ranking.sort(neighborFeatureTypes);
 
             // Create FEATURE_NODE for each neighbor feature type
             for (const auto& neighborFeatureType : neighborFeatureTypes) {
@@ -68,14 +73,23 @@ void NRTree::build(const NeighborhoodMgr& neighMgr, const std::map<FeatureType,
                 const auto& neighborInstances = star.neighbors.at(neighborFeatureType);
 
                 // Create single INSTANCE_VECTOR_NODE to store vector of neighbor instances
+                // Sorted by ordinal so neighbor sets can be intersected with a linear merge
                 NRNode* instanceVectorNode = new NRNode(INSTANCE_VECTOR_NODE);
                 instanceVectorNode->instanceVector = neighborInstances;  // Store entire vector
+                std::sort(instanceVectorNode->instanceVector.begin(), instanceVectorNode->instanceVector.end(),
+                    [](const SpatialInstance* a, const SpatialInstance* b) { return a->ordinal < b->ordinal; });
                 neighborFeatureNode->children.push_back(instanceVectorNode);
             }
         }
     }
 }
 
+const NRNode* NRTree::findStar(const SpatialInstance* instance) const {
+    const auto it = starIndex.find(instance->type);
+    if (it == starIndex.end() || instance->ordinal >= it->second.size()) return nullptr;
+    return it->second[instance->ordinal];
+}
+
 // --- Support functions for display (Debug) ---
 
 void NRTree::printTree() const {
@@ -115,7 +129,7 @@ void NRTree::printRecursive(NRNode* node, int level) const {
     // Level 1: FEATURE_NODE (center feature, sorted by feature count)
     // Level 2: INSTANCE_NODE (center instance, sorted by ID)
     // Level 3: FEATURE_NODE (neighbor feature, sorted by feature count)
-    // Level 4: INSTANCE_VECTOR_NODE (vector of neighbor instances, sorted alphabetically by ID)
+    // Level 4: INSTANCE_VECTOR_NODE (vector of neighbor instances, sorted by ordinal)
     // INSTANCE_VECTOR_NODE is a leaf, no children
 
     // Recursively print children
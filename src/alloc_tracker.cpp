@@ -0,0 +1,200 @@
+/**
+ * @file alloc_tracker.cpp
+ * @brief Implementation of the allocation tracker and the operator new / delete replacement
+ */
+
+#include "alloc_tracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+constexpr size_t MAX_THREAD_SLOTS = 256;     ///< Threads with a counter slot of their own; later threads share the last
+constexpr size_t MAX_PEAK_WINDOWS = 32;      ///< Peak windows open at the same time (bits of windowMask)
+constexpr int64_t LIVE_FLUSH_BYTES = 64 * 1024; ///< Per-thread live bytes batched before the global total is updated
+
+/**
+ * @brief Counters of one thread (own cache line, so threads do not share lines)
+ */
+struct alignas(64) ThreadSlot {
+    std::atomic<uint64_t> allocations{ 0 };
+    std::atomic<uint64_t> deallocations{ 0 };
+    std::atomic<uint64_t> bytes{ 0 };
+    std::atomic<int64_t> pendingLive{ 0 };  ///< Live bytes not yet added to liveBytes
+};
+
+std::atomic<bool> tracking{ false };
+ThreadSlot slots[MAX_THREAD_SLOTS];
+
+std::atomic<int64_t> liveBytes{ 0 };
+std::atomic<uint32_t> windowMask{ 0 };
+std::atomic<int64_t> windowPeaks[MAX_PEAK_WINDOWS];
+
+int64_t currentLive() {
+    int64_t live = liveBytes.load(std::memory_order_relaxed);
+    for (const ThreadSlot& slot : slots) live += slot.pendingLive.load(std::memory_order_relaxed);
+    return live;
+}
+
+#ifdef ENABLE_ALLOC_TRACKING
+
+std::atomic<size_t> nextSlot{ 0 };
+thread_local ThreadSlot* threadSlot = nullptr;
+
+ThreadSlot& currentSlot() {
+    if (!threadSlot) {
+        const size_t index = nextSlot.fetch_add(1, std::memory_order_relaxed);
+        threadSlot = &slots[index < MAX_THREAD_SLOTS ? index : MAX_THREAD_SLOTS - 1];
+    }
+    return *threadSlot;
+}
+
+void raisePeaks(int64_t live) {
+    const uint32_t mask = windowMask.load(std::memory_order_acquire);
+    for (size_t w = 0; w < MAX_PEAK_WINDOWS; ++w) {
+        if (!(mask & (1u << w))) continue;
+        int64_t peak = windowPeaks[w].load(std::memory_order_relaxed);
+        while (live > peak && !windowPeaks[w].compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    }
+}
+
+// Add a live-bytes change of the calling thread; the global total moves in batches
+void addLive(ThreadSlot& slot, int64_t delta) {
+    const int64_t pending = slot.pendingLive.fetch_add(delta, std::memory_order_relaxed) + delta;
+    if (pending > LIVE_FLUSH_BYTES || pending < -LIVE_FLUSH_BYTES) {
+        const int64_t flushed = slot.pendingLive.exchange(0, std::memory_order_relaxed);
+        const int64_t live = liveBytes.fetch_add(flushed, std::memory_order_relaxed) + flushed;
+        if (flushed > 0) raisePeaks(live);
+    }
+}
+
+/**
+ * @brief Header in front of every allocation: requested size and whether it was counted
+ *
+ * The header keeps the alignment of malloc (alignof(std::max_align_t)).
+ */
+struct alignas(alignof(std::max_align_t)) AllocationHeader {
+    size_t size;
+    bool counted;
+};
+
+void* trackedAllocate(size_t size) noexcept {
+    void* block = std::malloc(sizeof(AllocationHeader) + size);
+    if (!block) return nullptr;
+
+    AllocationHeader* header = static_cast<AllocationHeader*>(block);
+    header->size = size;
+    header->counted = tracking.load(std::memory_order_relaxed);
+    if (header->counted) {
+        ThreadSlot& slot = currentSlot();
+        slot.allocations.fetch_add(1, std::memory_order_relaxed);
+        slot.bytes.fetch_add(size, std::memory_order_relaxed);
+        addLive(slot, static_cast<int64_t>(size));
+    }
+    return header + 1;
+}
+
+void* trackedNew(size_t size) {
+    if (size == 0) size = 1;
+    for (;;) {
+        if (void* p = trackedAllocate(size)) return p;
+        const std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void trackedDelete(void* p) noexcept {
+    if (!p) return;
+    AllocationHeader* header = static_cast<AllocationHeader*>(p) - 1;
+    if (header->counted) {
+        ThreadSlot& slot = currentSlot();
+        slot.deallocations.fetch_add(1, std::memory_order_relaxed);
+        addLive(slot, -static_cast<int64_t>(header->size));
+    }
+    std::free(header);
+}
+
+#endif
+
+}
+
+
+#ifdef ENABLE_ALLOC_TRACKING
+
+// Replaceable global allocation functions (over-aligned variants keep their defaults)
+void* operator new(size_t size) { return trackedNew(size); }
+void* operator new[](size_t size) { return trackedNew(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return trackedAllocate(size ? size : 1); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return trackedAllocate(size ? size : 1); }
+void operator delete(void* p) noexcept { trackedDelete(p); }
+void operator delete[](void* p) noexcept { trackedDelete(p); }
+void operator delete(void* p, size_t) noexcept { trackedDelete(p); }
+void operator delete[](void* p, size_t) noexcept { trackedDelete(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { trackedDelete(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { trackedDelete(p); }
+
+#endif
+
+
+AllocationStats AllocationStats::since(const AllocationStats& earlier) const {
+    AllocationStats delta = *this;
+    delta.available = available && earlier.available;
+    delta.allocations = allocations - earlier.allocations;
+    delta.deallocations = deallocations - earlier.deallocations;
+    delta.bytes = bytes - earlier.bytes;
+    return delta;
+}
+
+
+bool AllocationTracker::enable() {
+#ifdef ENABLE_ALLOC_TRACKING
+    tracking.store(true, std::memory_order_relaxed);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool AllocationTracker::active() {
+    return tracking.load(std::memory_order_relaxed);
+}
+
+AllocationStats AllocationTracker::read() {
+    AllocationStats stats;
+    stats.available = active();
+    if (!stats.available) return stats;
+    for (const ThreadSlot& slot : slots) {
+        stats.allocations += slot.allocations.load(std::memory_order_relaxed);
+        stats.deallocations += slot.deallocations.load(std::memory_order_relaxed);
+        stats.bytes += slot.bytes.load(std::memory_order_relaxed);
+    }
+    stats.liveBytes = currentLive();
+    stats.peakLiveBytes = stats.liveBytes;
+    return stats;
+}
+
+int AllocationTracker::openPeakWindow() {
+    if (!active()) return -1;
+    uint32_t mask = windowMask.load(std::memory_order_relaxed);
+    for (;;) {
+        if (mask == ~0u) return -1;
+        int window = 0;
+        while (mask & (1u << window)) ++window;
+        windowPeaks[window].store(currentLive(), std::memory_order_relaxed);
+        if (windowMask.compare_exchange_weak(mask, mask | (1u << window), std::memory_order_acq_rel)) return window;
+    }
+}
+
+int64_t AllocationTracker::peakOf(int window) {
+    if (window < 0) return 0;
+    const int64_t peak = windowPeaks[window].load(std::memory_order_relaxed);
+    const int64_t live = currentLive();
+    return live > peak ? live : peak;
+}
+
+void AllocationTracker::closePeakWindow(int window) {
+    if (window < 0) return;
+    windowMask.fetch_and(~(1u << window), std::memory_order_acq_rel);
+}
@@ -37,9 +37,25 @@ AppConfig ConfigLoader::load(const std::string& configPath) {
             std::string value;
             if (std::getline(is_line, value)) {
                 if (key == "dataset_path") config.datasetPath = value;
+                else if (key == "report_path") config.reportPath = (value == "none") ? "" : value;
+                else if (key == "trace_path") config.tracePath = (value == "none") ? "" : value;
                 else if (key == "neighbor_distance") config.neighborDistance = std::stod(value);
                 else if (key == "min_prevalence") config.minPrev = std::stod(value);
                 else if (key == "min_cond_prob") config.minCondProb = std::stod(value);
+                else if (key == "max_pattern_size") config.maxPatternSize = std::stoul(value);
+                else if (key == "memory_budget_mb") config.memoryBudgetMB = std::stoul(value);
+                else if (key == "memory_sample_ms") config.memorySampleMs = static_cast<unsigned>(std::stoul(value));
+                else if (key == "hardware_counters") config.hardwareCounters = (value == "true" || value == "1");
+                else if (key == "allocation_tracking") config.allocationTracking = (value == "true" || value == "1");
+                else if (key == "mining_strategy") {
+                    config.miningStrategy = (value == "depth_first" || value == "dfs")
+                        ? MiningStrategy::DEPTH_FIRST : MiningStrategy::LEVEL_WISE;
+                }
+                else if (key == "cell_split_threshold") config.cellSplitThreshold = std::stoul(value);
+                else if (key == "coordinate_system") {
+                    config.coordinateSystem = (value == "geodesic" || value == "latlon")
+                        ? CoordinateSystem::GEODESIC : CoordinateSystem::PLANAR;
+                }
                 else if (key == "debug_mode") config.debugMode = (value == "true" || value == "1");
             }
         }
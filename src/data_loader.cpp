@@ -4,7 +4,9 @@
  */
 
 #include "data_loader.h"
+#include "trace.h"
 #include <iostream>
+#include <unordered_map>
 
 using namespace csv;
 
@@ -14,20 +16,32 @@ using namespace csv;
  * @param filepath Path to the CSV file
  * @return std::vector<SpatialInstance> Vector of loaded spatial instances
  * 
- * Expects CSV with columns: Feature, Instance, LocX, LocY.
+ * Expects CSV with columns: Feature, Instance, LocX, LocY (or X, Y).
  * Instance IDs are generated as: FeatureType + InstanceNumber (e.g., "A1", "B2").
+ * Ordinals are assigned per feature type in file order.
  */
 std::vector<SpatialInstance> DataLoader::load_csv(const std::string& filepath) {
+    TRACE_SCOPE("load_csv");
     CSVReader reader(filepath);
     std::vector<SpatialInstance> instances;
+    std::unordered_map<FeatureType, uint32_t> nextOrdinal;
+
+    // Coordinate columns are LocX/LocY, or X/Y in some of the bundled datasets
+    const int xColumn = (reader.index_of("LocX") != CSV_NOT_FOUND) ? reader.index_of("LocX") : reader.index_of("X");
+    const int yColumn = (reader.index_of("LocY") != CSV_NOT_FOUND) ? reader.index_of("LocY") : reader.index_of("Y");
+    if (xColumn == CSV_NOT_FOUND || yColumn == CSV_NOT_FOUND) {
+        std::cerr << "Error: " << filepath << " has no LocX/LocY (or X/Y) columns.\n";
+        return instances;
+    }
 
     for (auto& row : reader) {
         SpatialInstance instance;
         
         instance.type = row["Feature"].get<FeatureType>();
         instance.id = instanceID(instance.type + std::to_string(row["Instance"].get<int>()));
-        instance.x = row["LocX"].get<double>();
-        instance.y = row["LocY"].get<double>();
+        instance.x = row[static_cast<size_t>(xColumn)].get<double>();
+        instance.y = row[static_cast<size_t>(yColumn)].get<double>();
+        instance.ordinal = nextOrdinal[instance.type]++;
         
         instances.push_back(instance);
     }
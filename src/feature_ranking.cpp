@@ -0,0 +1,47 @@
+/**
+ * @file feature_ranking.cpp
+ * @brief Implementation of the feature ranking
+ */
+
+#include "feature_ranking.h"
+#include "utils.h"
+#include <algorithm>
+
+FeatureRanking::FeatureRanking(const std::vector<SpatialInstance>& instances)
+    : featureCounts(countInstancesByFeature(instances))
+{
+    rankFeatures();
+}
+
+FeatureRanking::FeatureRanking(const std::map<FeatureType, int>& featureCounts)
+    : featureCounts(featureCounts)
+{
+    rankFeatures();
+}
+
+// Step 2: Sorting features in ascending order of the quantity of instances
+void FeatureRanking::rankFeatures() {
+    sortedFeatures.clear();
+    sortedFeatures.reserve(featureCounts.size());
+    for (const auto& entry : featureCounts) {
+        sortedFeatures.push_back(entry.first);
+    }
+    std::sort(sortedFeatures.begin(), sortedFeatures.end(), [this](const FeatureType& a, const FeatureType& b) {
+        return featureLess(a, b, featureCounts);
+    });
+
+    ranks.clear();
+    ranks.reserve(sortedFeatures.size());
+    for (size_t rank = 0; rank < sortedFeatures.size(); ++rank) {
+        ranks[sortedFeatures[rank]] = rank;
+    }
+}
+
+int FeatureRanking::count(const FeatureType& feature) const {
+    const auto it = featureCounts.find(feature);
+    return (it != featureCounts.end()) ? it->second : 0;
+}
+
+void FeatureRanking::sort(std::vector<FeatureType>& features) const {
+    std::sort(features.begin(), features.end(), comparator());
+}
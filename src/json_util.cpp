@@ -0,0 +1,31 @@
+/**
+ * @file json_util.cpp
+ * @brief Implementation of the JSON helpers
+ */
+
+#include "json_util.h"
+#include <iomanip>
+#include <sstream>
+
+std::string jsonString(const std::string& text) {
+    std::ostringstream out;
+    out << '"';
+    for (const char c : text) {
+        switch (c) {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+            }
+            else {
+                out << c;
+            }
+        }
+    }
+    out << '"';
+    return out.str();
+}
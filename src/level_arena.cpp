@@ -0,0 +1,65 @@
+/**
+ * @file level_arena.cpp
+ * @brief Implementation of the per-level arenas
+ */
+
+#include "level_arena.h"
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+LevelArena::LevelArena() {
+#ifdef _OPENMP
+    const size_t threads = static_cast<size_t>(omp_get_max_threads());
+#else
+    const size_t threads = 1;
+#endif
+    arenas.reserve(threads);
+    for (size_t t = 0; t < threads; ++t) arenas.push_back(std::make_unique<ThreadArena>());
+}
+
+std::pmr::memory_resource* LevelArena::local() {
+#ifdef _OPENMP
+    // Thread numbers are only unique within the innermost team
+    if (omp_get_active_level() > 1) {
+        throw std::logic_error("LevelArena::local: called from a nested parallel region");
+    }
+    const size_t thread = static_cast<size_t>(omp_get_thread_num());
+#else
+    const size_t thread = 0;
+#endif
+    // A monotonic buffer is not thread-safe: never hand one arena to a second thread
+    if (thread >= arenas.size()) {
+        throw std::logic_error("LevelArena::local: thread " + std::to_string(thread)
+            + " has no arena (" + std::to_string(arenas.size()) + " arenas)");
+    }
+    return &arenas[thread]->buffer;
+}
+
+size_t LevelArena::bytesReserved() const {
+    size_t bytes = 0;
+    for (const auto& arena : arenas) bytes += arena->upstream.reserved;
+    return bytes;
+}
+
+
+// Plain operator new for the usual alignments, so the allocation tracker sees the arena
+// blocks (it does not count the over-aligned variant new_delete_resource may pick)
+void* LevelArena::CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    void* p = (alignment <= alignof(std::max_align_t))
+        ? ::operator new(bytes)
+        : std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    reserved += bytes;
+    return p;
+}
+
+void LevelArena::CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    if (alignment <= alignof(std::max_align_t)) ::operator delete(p);
+    else std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    reserved -= bytes;
+}
@@ -4,22 +4,20 @@
  */
 
 #include "config.h"
-#include "data_loader.h"
-#include "spatial_index.h"
-#include "neighborhood_mgr.h"
-#include "miner.h"
+#include "mining_session.h"
 #include "types.h"
 #include "utils.h"
+#include "feature_ranking.h"
+#include "run_report.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "perf_counters.h"
+#include "alloc_tracker.h"
 #include <iostream>
 #include <fstream>
 #include <chrono>
 #include <iomanip>
-
- //Show memmory usage
-#include <windows.h>
-#include <psapi.h>
-#include <stdio.h>
-#pragma comment(lib, "psapi.lib")
+#include <exception>
 
 int main(int argc, char* argv[]) {
     auto programStart = std::chrono::high_resolution_clock::now();
@@ -31,38 +29,81 @@ int main(int argc, char* argv[]) {
     std::string config_path = (argc > 1) ? argv[1] : "./config/config.txt";
     AppConfig config = ConfigLoader::load(config_path);
 
-    // ========================================================================
-    // Step 2: Load Data
-    // ========================================================================
-    auto instances = DataLoader::load_csv(config.datasetPath);
+    if (!config.tracePath.empty()) {
+#ifdef ENABLE_TRACING
+        Tracer::instance().start(config.tracePath);
+#else
+        std::cerr << "Warning: trace_path is set, but tracing is not compiled in (ENABLE_TRACING).\n";
+#endif
+    }
 
-    // ========================================================================
-    // Step 3: Build Spatial Index
-    // ========================================================================
-    SpatialIndex spatial_idx(config.neighborDistance);
-    auto neighborPairs = spatial_idx.findNeighborPair(instances);
+    // Hardware counters are opened before the first parallel region (see HardwareCounters::open)
+    if (config.hardwareCounters) HardwareCounters::instance().open();
 
-    // ========================================================================
-    // Step 4: Materialize Neighborhoods
-    // ========================================================================
-    std::map<FeatureType, int> featureCount = countInstancesByFeature(instances);
+    if (config.allocationTracking && !AllocationTracker::enable()) {
+        std::cerr << "Warning: allocation_tracking is set, but the tracker is not compiled in (ENABLE_ALLOC_TRACKING).\n";
+    }
 
-    NeighborhoodMgr neighbor_mgr;
-    neighbor_mgr.buildFromPairs(neighborPairs, featureCount);
+    // Per-stage resources and an RSS timeline sampled in the background, written to config.reportPath
+    const StageTimer totalTimer;
+    RunReport report;
+    // The timeline only goes into the report: without one, no sampling thread is started
+    MemorySampler memorySampler;
+    if (!config.reportPath.empty()) memorySampler.start(config.memorySampleMs);
+    auto beginStage = [&](const std::string& name) {
+        memorySampler.setStage(name);
+        return StageTimer();
+    };
+    auto finishStage = [&](const std::string& name, const StageTimer& timer) {
+        report.addStage(timer.stop(name));
+        if (config.debugMode) printDuration(name, timer.startTime(), std::chrono::high_resolution_clock::now());
+    };
 
-    NRTree orderedNRTree;
-    orderedNRTree.build(neighbor_mgr, featureCount,instances);
+    // ========================================================================
+    // Step 2-4: Load Data, Build Spatial Index, Materialize Neighborhoods
+    // ========================================================================
+    IndexOptions indexOptions;
+    indexOptions.neighborDistance = config.neighborDistance;
+    indexOptions.cellSplitThreshold = config.cellSplitThreshold;
+    indexOptions.coordinateSystem = config.coordinateSystem;
+    const MiningSession session(config.datasetPath, indexOptions,
+        [&memorySampler](const std::string& stage) { memorySampler.setStage(stage); });
+    for (const StageStats& stage : session.indexStages()) {
+        report.addStage(stage);
+        if (config.debugMode) std::cout << "[PERF] " << stage.name << ": " << stage.wallSeconds * 1000.0 << " ms\n";
+    }
 
     // ========================================================================
     // Step 5: Mine Colocation Patterns
     // ========================================================================
-    JoinlessMiner miner;
+    MiningOptions miningOptions;
+    miningOptions.maxPatternSize = config.maxPatternSize;
+    miningOptions.strategy = config.miningStrategy;
+    miningOptions.memoryBudgetMB = config.memoryBudgetMB;
+    miningOptions.debugOutput = config.debugMode;
 
     // Callback đơn giản hơn, không dùng \r để tránh mất log debug
     auto progressCallback = [](int currentStep, int totalSteps, const std::string& message, double percentage) {
         };
 
-    auto colocations = miner.mineColocations(config.minPrev, orderedNRTree, instances, featureCount, progressCallback);
+    const StageTimer miningTimer = beginStage("mining");
+    MiningResult mined;
+    try {
+        mined = session.mine(config.minPrev, miningOptions, progressCallback);
+    }
+    catch (const std::exception& e) {
+        // A spilled table that cannot be read back would drop patterns from the results
+        std::cerr << "Error: mining aborted: " << e.what() << "\n";
+        return 1;
+    }
+    const std::vector<Colocation>& colocations = mined.patterns;
+    finishStage("mining", miningTimer);
+    for (const LevelStats& level : mined.levels) {
+        if (level.spilledTables == 0) continue;
+        std::cout << "[Memory] Level " << level.patternSize << ": spilled " << level.spilledTables
+            << " table instances (" << std::fixed << std::setprecision(1)
+            << level.spilledBytes / (1024.0 * 1024.0) << " MB) to disk\n";
+    }
 
     // ========================================================================
     // Final Report
@@ -72,13 +113,8 @@ int main(int argc, char* argv[]) {
 
     // --- REPORT GENERATION (FILE ONLY) ---
     // 1. Get Memory Info (Peak)
-    HANDLE handle = GetCurrentProcess();
-    PROCESS_MEMORY_COUNTERS memCounter;
-    SIZE_T peakMemMB = 0;
-
-    if (GetProcessMemoryInfo(handle, &memCounter, sizeof(memCounter))) {
-        peakMemMB = memCounter.PeakWorkingSetSize / 1024 / 1024; // Convert to MB
-    }
+    memorySampler.setStage("report");
+    const size_t peakMemMB = static_cast<size_t>(sampleResourceUsage().peakRSSMB);
 
     // 2. Write to File
     std::ofstream outFile("../results.txt");
@@ -89,7 +125,7 @@ int main(int argc, char* argv[]) {
     // (A) Thông tin Dataset & Config
     outFile << "=== FINAL REPORT ===\n";
     outFile << "Dataset Path:      " << config.datasetPath << "\n";
-    outFile << "Total Instances:   " << instances.size() << "\n";
+    outFile << "Total Instances:   " << session.instanceCount() << "\n";
     outFile << "Neighbor Distance: " << config.neighborDistance << "\n";
     outFile << "Min Prevalence:    " << config.minPrev << "\n";
     outFile << "----------------------------------------\n";
@@ -121,6 +157,40 @@ int main(int argc, char* argv[]) {
 
     outFile.close();
 
+    if (Tracer::active() && !Tracer::instance().finish()) {
+        std::cerr << "Cannot write the trace to " << config.tracePath << ".\n";
+    }
+
+    // 3. JSON performance report
+    if (!config.reportPath.empty()) {
+        memorySampler.stop();
+        const StageStats total = totalTimer.stop("total");
+        report.setText("dataset", config.datasetPath);
+        report.setNumber("instances", static_cast<double>(session.instanceCount()));
+        report.setNumber("neighbor_pairs", static_cast<double>(session.neighborPairCount()));
+        report.setNumber("neighbor_distance", config.neighborDistance);
+        report.setNumber("min_prevalence", config.minPrev);
+        report.setText("mining_strategy", config.miningStrategy == MiningStrategy::DEPTH_FIRST ? "depth_first" : "level_wise");
+        report.setNumber("patterns_found", static_cast<double>(colocations.size()));
+        report.setNumber("wall_s", total.wallSeconds);
+        report.setNumber("cpu_s", total.cpuSeconds);
+        report.setNumber("peak_rss_mb", total.processPeakRSSMB);
+        report.setNumber("minor_faults", static_cast<double>(total.minorFaults));
+        report.setNumber("major_faults", static_cast<double>(total.majorFaults));
+        report.setNumber("voluntary_ctx_switches", static_cast<double>(total.voluntaryContextSwitches));
+        report.setNumber("involuntary_ctx_switches", static_cast<double>(total.involuntaryContextSwitches));
+        if (total.allocations.available) {
+            report.setNumber("allocations", static_cast<double>(total.allocations.allocations));
+            report.setNumber("allocated_mb", total.allocations.bytes / (1024.0 * 1024.0));
+            report.setNumber("peak_live_heap_mb", total.allocations.peakLiveBytes / (1024.0 * 1024.0));
+        }
+        report.setLevels(mined.levels);
+        report.setTimeline(memorySampler.timeline());
+        if (!report.writeJson(config.reportPath)) {
+            std::cerr << "Cannot write the run report to " << config.reportPath << ".\n";
+        }
+    }
+
     std::cout << "Done! Please check 'result.txt'.\n";
     return 0;
 }
\ No newline at end of file
@@ -11,42 +11,102 @@
 #include "neighborhood_mgr.h"
 #include "NRTree.h"
 #include "types.h"
+#include "pattern_metrics.h"
+#include "feature_ranking.h"
+#include "table_instance.h"
+#include "table_spill.h"
+#include "trace.h"
 #include <algorithm>
+#include <atomic>
+#include <exception>
 #include <unordered_set>
+#include <set>
 #include <map>
 #include <string>
 #include <iostream>
 #include <omp.h> 
 #include <iomanip>
 #include <chrono>
-#include <unordered_set>
+#include <functional>
+#include <memory>
+
+namespace {
+
+// True if two patterns of a lexicographically sorted list share their (k-1)-prefix,
+// i.e. the list can produce at least one (k+1)-candidate
+bool hasSharedPrefix(const std::vector<Colocation>& sortedPatterns) {
+    for (size_t i = 1; i < sortedPatterns.size(); ++i) {
+        const Colocation& previous = sortedPatterns[i - 1];
+        const Colocation& current = sortedPatterns[i];
+        if (previous.size() == current.size() &&
+            std::equal(previous.begin(), previous.end() - 1, current.begin())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Bitset of a pattern: the bit of a feature is its rank
+template <typename Mask>
+Mask patternMask(const Colocation& pattern, const FeatureRanking& featureRanking) {
+    Mask mask(featureRanking.size());
+    for (const auto& feature : pattern) mask.set(featureRanking.rank(feature));
+    return mask;
+}
+
+// Pattern order of the final result: by size, then lexicographically in feature order
+bool resultLess(const Colocation& a, const Colocation& b, const FeatureRanking& featureRanking) {
+    if (a.size() != b.size()) return a.size() < b.size();
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), featureRanking.comparator());
+}
+
+}
+
 
 std::vector<Colocation> JoinlessMiner::mineColocations(
     double minPrev,
-    NRTree& orderedNRTree,
-    const std::vector<SpatialInstance>& instances,
-    const std::map<FeatureType, int>& featureCount,
+    const NRTree& orderedNRTree,
+    const FeatureRanking& featureRanking,
+    const MiningOptions& options,
     ProgressCallback progressCb
 ) {
+    TRACE_SCOPE("mineColocations");
     auto minerStart = std::chrono::high_resolution_clock::now();
     this->progressCallback = progressCb;
+    debugOutput = options.debugOutput;
 
     // --- INIT ---
     int k = 2;
-    const std::vector<FeatureType> allFeatureTypes = getAllObjectTypes(instances);
-    const std::vector<FeatureType> sortedTypes = featureSort(allFeatureTypes, instances);
+    ranking = featureRanking;
+    const std::map<FeatureType, int>& featureCount = ranking.counts();
+    const std::vector<FeatureType>& sortedTypes = ranking.features();
     const double delta = calculateDelta(sortedTypes, featureCount);
+    rareWeights = RareWeightTable(sortedTypes, featureCount, delta);
+    instanceLookup = InstanceLookup(orderedNRTree);
+    levelStatistics.clear();
+
+    if (options.strategy == MiningStrategy::DEPTH_FIRST) {
+        if (ranking.size() <= FeatureMask<1>::capacity()) {
+            return mineDepthFirst<FeatureMask<1>>(minPrev, orderedNRTree, options);
+        }
+        if (ranking.size() <= FeatureMask<2>::capacity()) {
+            return mineDepthFirst<FeatureMask<2>>(minPrev, orderedNRTree, options);
+        }
+        return mineDepthFirst<DynamicFeatureMask>(minPrev, orderedNRTree, options);
+    }
 
     std::vector<Colocation> prevColocations;
-    std::map<Colocation, std::vector<ColocationInstance>> prevTableInstances;
+    // Arena of the previous level's extension sets: declared first, so it outlives them
+    std::unique_ptr<LevelArena> prevArena;
+    std::map<Colocation, PackedTable> prevTableInstances;
+    std::map<Colocation, ExtensionTable> prevExtensions;
 
-    // Initialize T1 (Table Instance for k=1)
-    // Map structure: {Key: [FeatureType], Value: List of instance rows}
-    for (const auto& instance : instances) {
-        Colocation key = { instance.type };
-        ColocationInstance row = { &instance };
-        prevTableInstances[key].push_back(row);
-    }
+    // PR/PI/WPI of every candidate evaluated at the previous level
+    PatternMetricsStore prevMetrics;
+
+    // Previous-level tables written to disk to stay within options.memoryBudgetMB
+    std::unique_ptr<SpilledTables> prevSpilled;
+    const size_t budgetBytes = options.memoryBudgetMB * 1024 * 1024;
 
     std::vector<Colocation> allPrevalentColocations;
 
@@ -58,50 +118,247 @@ std::vector<Colocation> JoinlessMiner::mineColocations(
 
     // --- MAIN LOOP ---
     while (!prevColocations.empty()) {
-        std::map<Colocation, std::vector<ColocationInstance>> tableInstances;
+        if (options.maxPatternSize != 0 && static_cast<size_t>(k) > options.maxPatternSize) break;
+        // Table instances of this level are only needed if a (k+1)-level can follow
+        const bool lastAllowedLevel = options.maxPatternSize != 0 && static_cast<size_t>(k) >= options.maxPatternSize;
+
+        // Extension sets of this level are allocated from its arena and released in one
+        // piece once the next level has consumed them
+        auto arena = std::make_unique<LevelArena>();
+        std::map<Colocation, PackedTable> tableInstances;
+        std::map<Colocation, ExtensionTable> extensions;
+        PatternMetricsStore levelMetrics;
+        TRACE_SCOPE("level " + std::to_string(k));
+        const StageTimer levelTimer;
+        LevelStats levelStats;
+        levelStats.patternSize = static_cast<size_t>(k);
+        // Tables of this level written to disk to stay within options.memoryBudgetMB
+        std::unique_ptr<SpilledTables> spilled;
+        // Tables of this level held in memory while it was generated
+        size_t generatedBytes = 0;
 
         // 1. Generate Candidates
-        std::vector<Colocation> candidates = generateCandidates(prevColocations, featureCount);
+        std::vector<Colocation> candidates = generateCandidates(prevColocations, ranking);
         if (candidates.empty()) break;
 
         // 2. Filter Candidates
         std::vector<Colocation> filteredCandidates = candidates;
         if (k != 2) {
-            filteredCandidates = filterCandidates(candidates, prevColocations, prevTableInstances, minPrev, featureCount, delta);
+            filteredCandidates = filterCandidates(candidates, prevMetrics, minPrev, ranking, delta);
         }
+        levelStats.candidates = candidates.size();
+        levelStats.filtered = filteredCandidates.size();
 
-        if (filteredCandidates.empty()) break;
-
-        // 3. Generate Table Instances (Phần quan trọng nhất cần check)
-        tableInstances = genTableInstance(filteredCandidates, prevTableInstances, orderedNRTree);
+        if (filteredCandidates.empty()) {
+            levelStats.resources = levelTimer.stop("level " + std::to_string(k));
+            levelStatistics.push_back(levelStats);
+            break;
+        }
 
-        size_t totalRows = 0;
-        for (const auto& pair : tableInstances) totalRows += pair.second.size();
+        if (k == 2) {
+            // 3-4. Fused k=2 stage: count participants straight from the star neighborhoods,
+            // then materialize table instances only for the prevalent pairs
+            const auto pairParticipation = countPairParticipation(orderedNRTree, featureCount);
+            std::vector<PatternMetrics> pairMetrics(filteredCandidates.size());
+            for (size_t c = 0; c < filteredCandidates.size(); ++c) {
+                const Colocation& candidate = filteredCandidates[c];
+                PatternMetrics& metrics = pairMetrics[c];
+                metrics.participationRatios.assign(candidate.size(), 0.0);
+                const auto it = pairParticipation.find(candidate);
+                if (it != pairParticipation.end()) {
+                    for (size_t i = 0; i < candidate.size(); ++i) {
+                        metrics.participationRatios[i] = static_cast<double>(it->second.bitmaps[i].count()) / featureCount.at(candidate[i]);
+                    }
+                    metrics.rowCount = it->second.rowCount;
+                }
+            }
+            fillPrevalence(filteredCandidates, pairMetrics, minPrev);
+            for (size_t c = 0; c < filteredCandidates.size(); ++c) {
+                levelMetrics.add(filteredCandidates[c], std::move(pairMetrics[c]));
+            }
+            prevColocations = levelMetrics.prevalentPatterns();
+            if (!lastAllowedLevel && hasSharedPrefix(prevColocations)) {
+                tableInstances = genPairTableInstance(prevColocations, orderedNRTree, budgetBytes, spilled,
+                    generatedBytes, *arena, extensions);
+            }
+        }
+        else {
+            // 3. Generate Table Instances
+            // (participation is counted while the rows are generated). If no two candidates
+            // share a prefix, no (k+1)-candidate can follow and the level is evaluated count-only.
+            const bool countOnly = lastAllowedLevel || !hasSharedPrefix(filteredCandidates);
+            std::map<Colocation, PatternMetrics> participation;
+            tableInstances = genTableInstance(filteredCandidates, prevTableInstances, prevExtensions,
+                prevSpilled.get(), orderedNRTree, minPrev, countOnly, budgetBytes, spilled, generatedBytes,
+                *arena, extensions, participation);
+
+            // 4. Select Prevalent
+            prevColocations = selectPrevColocations(
+                filteredCandidates,
+                participation,
+                minPrev,
+                levelMetrics
+            );
+            trimExtensions(extensions, prevColocations);
+        }
 
-        // 4. Select Prevalent
-        prevColocations = selectPrevColocations(
-            filteredCandidates,
-            tableInstances,
-            minPrev,
-            featureCount,
-            delta
-        );
+        // Only prevalent patterns are prefixes at the next level; spill the largest of their
+        // tables if they still do not fit into the memory budget
+        dropNonPrevalentTables(tableInstances, prevColocations);
+        if (budgetBytes != 0) {
+            spillOverBudget(tableInstances, extensions, budgetBytes, spilled);
+        }
+        if (spilled) {
+            levelStats.spilledTables = spilled->size();
+            levelStats.spilledBytes = spilled->bytesWritten();
+        }
+        compactExtensions(extensions, arena);
 
         if (!prevColocations.empty()) {
             allPrevalentColocations.insert(allPrevalentColocations.end(), prevColocations.begin(), prevColocations.end());
         }
 
+        for (size_t i = 0; i < levelMetrics.size(); ++i) levelStats.tableRows += levelMetrics.metrics(i).rowCount;
+        levelStats.prevalent = prevColocations.size();
+        levelStats.bytesHeld = levelTableBytes(tableInstances, extensions);
+        levelStats.peakBytesHeld = std::max(generatedBytes, levelStats.bytesHeld);
+        levelStats.arenaBytes = arena->bytesReserved();
+        levelStats.resources = levelTimer.stop("level " + std::to_string(k));
+        levelStatistics.push_back(levelStats);
+
         prevTableInstances = std::move(tableInstances);
+        prevExtensions = std::move(extensions);
+        prevArena = std::move(arena);
+        prevMetrics = std::move(levelMetrics);
+        prevSpilled = std::move(spilled);
         k++;
     }
     return allPrevalentColocations;
 }
 
 
+template <typename Mask>
+std::vector<Colocation> JoinlessMiner::mineDepthFirst(
+    double minPrev,
+    const NRTree& orderedNRTree,
+    const MiningOptions& options
+) {
+    std::vector<Colocation> allPrevalentColocations;
+    const NRNode* root = orderedNRTree.getRoot();
+    if (!root) return allPrevalentColocations;
+
+    // Metrics of every pattern evaluated so far: Lemma 2 needs the prevalent flag of the
+    // subsets containing f_min, Lemma 3 the PI of the subset without it
+    PatternMetricsStore evaluated;
+    MaskHashMap<Mask> evaluatedIndex(ranking.size() * ranking.size(), ranking.size());
+
+    // Evaluate the children pattern + g (g in joinFeatures) count-only, then descend into
+    // the prevalent ones, last feature first. Only the tables of the current path are alive.
+    std::function<void(const Colocation&, const PackedTable&, const ExtensionTable&,
+        const std::vector<FeatureType>&)> explore;
+    explore = [&](const Colocation& pattern, const PackedTable& rows,
+        const ExtensionTable& ext, const std::vector<FeatureType>& joinFeatures) {
+        const size_t childSize = pattern.size() + 1;
+        if (options.maxPatternSize != 0 && childSize > options.maxPatternSize) return;
+        TRACE_SCOPE("explore " + patternName(pattern));
+
+        // 1. Candidates: pattern + g for every prevalent sibling pattern' + g, filtered
+        std::vector<Colocation> children;
+        std::vector<FeatureType> childFeatures;
+        for (const auto& feature : joinFeatures) {
+            Colocation child = pattern;
+            child.push_back(feature);
+            if (childSize > 2 && !passesSubsetPruning(child, evaluatedIndex, evaluated, minPrev, ranking)) continue;
+            children.push_back(std::move(child));
+            childFeatures.push_back(feature);
+        }
+        if (children.empty()) return;
+
+        // 2. Count-only evaluation of all children in one pass over the rows
+        std::vector<PackedTable> noRows;
+        std::vector<ExtensionTable> noExtensions;
+        std::vector<PatternMetrics> childMetrics;
+        extendPrefix(pattern, rows, &ext, childFeatures, orderedNRTree, minPrev, true,
+            std::pmr::get_default_resource(), noRows, noExtensions, childMetrics, nullptr);
+        fillPrevalence(children, childMetrics, minPrev);
+
+        if (levelStatistics.size() < childSize - 1) levelStatistics.resize(childSize - 1);
+        LevelStats& sizeStats = levelStatistics[childSize - 2];
+        sizeStats.patternSize = childSize;
+        sizeStats.candidates += joinFeatures.size();
+        sizeStats.filtered += children.size();
+
+        std::vector<FeatureType> prevalentFeatures;
+        for (size_t c = 0; c < children.size(); ++c) {
+            sizeStats.tableRows += childMetrics[c].rowCount;
+            if (childMetrics[c].prevalent) {
+                ++sizeStats.prevalent;
+                prevalentFeatures.push_back(childFeatures[c]);
+                allPrevalentColocations.push_back(children[c]);
+            }
+            evaluatedIndex.insert(patternMask<Mask>(children[c], ranking), evaluated.size());
+            evaluated.add(children[c], std::move(childMetrics[c]));
+        }
+
+        // 3. Materialize prevalent children along the path (reverse order, so every subset of
+        //    a later candidate is evaluated before it)
+        for (size_t p = prevalentFeatures.size(); p-- > 0;) {
+            const std::vector<FeatureType> laterFeatures(prevalentFeatures.begin() + p + 1, prevalentFeatures.end());
+            if (laterFeatures.empty()) continue; // No grandchild can be generated
+            if (options.maxPatternSize != 0 && childSize >= options.maxPatternSize) continue;
+
+            std::vector<PackedTable> childRows;
+            std::vector<ExtensionTable> childExtensions;
+            std::vector<PatternMetrics> unused;
+            extendPrefix(pattern, rows, &ext, { prevalentFeatures[p] }, orderedNRTree, minPrev, false,
+                std::pmr::get_default_resource(), childRows, childExtensions, unused, &laterFeatures);
+
+            Colocation child = pattern;
+            child.push_back(prevalentFeatures[p]);
+            explore(child, childRows[0], childExtensions[0], laterFeatures);
+        }
+    };
+
+    // Root level: one single-feature pattern per feature, last feature first. Its rows
+    // (width 1) are the star centers and S({c}, g) = Neigh(c, g) for every feature g ranked after it.
+    const std::vector<FeatureType>& sortedTypes = ranking.features();
+    for (size_t r = sortedTypes.size(); r-- > 0;) {
+        const FeatureType& feature = sortedTypes[r];
+        const auto featureNodeIt = std::find_if(root->children.begin(), root->children.end(),
+            [&feature](const NRNode* node) { return node->featureType == feature; });
+        if (featureNodeIt == root->children.end()) continue;
+
+        ExtensionTable ext;
+        ext.features.assign(sortedTypes.begin() + r + 1, sortedTypes.end());
+        if (ext.features.empty()) continue;
+        std::vector<size_t> ranks;
+        for (const auto& extFeature : ext.features) ranks.push_back(ranking.rank(extFeature));
+
+        PackedTable rows(1);
+        rows.reserve((*featureNodeIt)->children.size());
+        for (const auto* instanceNode : (*featureNodeIt)->children) {
+            rows.push_back(&instanceNode->data->ordinal);
+            const auto neighborSets = starNeighborSets(instanceNode, ext.features, ranks);
+            std::pmr::vector<ExtensionTable::InstanceSet> rowSets(ext.features.size());
+            for (size_t j = 0; j < rowSets.size(); ++j) {
+                if (neighborSets[j]) rowSets[j].assign(neighborSets[j]->begin(), neighborSets[j]->end());
+            }
+            ext.sets.push_back(std::move(rowSets));
+        }
+        explore({ feature }, rows, ext, ext.features);
+    }
+
+    // Same order as the level-wise miner: by size, then feature order
+    std::sort(allPrevalentColocations.begin(), allPrevalentColocations.end(),
+        [this](const Colocation& a, const Colocation& b) { return resultLess(a, b, ranking); });
+    return allPrevalentColocations;
+}
+
+
 
 std::vector<Colocation> JoinlessMiner::generateCandidates(
     const std::vector<Colocation>& prevPrevalent,
-    const std::map<FeatureType, int>& featureCount)
+    const FeatureRanking& featureRanking)
 {
     // Implementation of gen_candidate_patterns (Step 8)
     std::vector<Colocation> candidates;
@@ -110,157 +367,182 @@ std::vector<Colocation> JoinlessMiner::generateCandidates(
         return candidates;
     }
 
-    const size_t patternSize = prevPrevalent[0].size();
-
-    // Join phase: generate k-size candidates from (k-1)-size prevalent patterns
-    for (size_t firstPatternIdx = 0; firstPatternIdx < prevPrevalent.size(); firstPatternIdx++) {
-        for (size_t secondPatternIdx = firstPatternIdx + 1; secondPatternIdx < prevPrevalent.size(); secondPatternIdx++) {
-            // Take prefix of k-1 first element
-            const Colocation prefix1(prevPrevalent[firstPatternIdx].begin(),
-                prevPrevalent[firstPatternIdx].end() - 1);
-            const Colocation prefix2(prevPrevalent[secondPatternIdx].begin(),
-                prevPrevalent[secondPatternIdx].end() - 1);
+    // Order patterns lexicographically by feature order; lists produced by the miner
+    // already are, so this is normally just the is_sorted check
+    const auto featureOrder = featureRanking.comparator();
+    const auto patternOrder = [&featureOrder](const Colocation* a, const Colocation* b) {
+        return std::lexicographical_compare(a->begin(), a->end(), b->begin(), b->end(), featureOrder);
+    };
+    std::vector<const Colocation*> sortedPrevalent;
+    sortedPrevalent.reserve(prevPrevalent.size());
+    for (const auto& pattern : prevPrevalent) {
+        sortedPrevalent.push_back(&pattern);
+    }
+    if (!std::is_sorted(sortedPrevalent.begin(), sortedPrevalent.end(), patternOrder)) {
+        std::sort(sortedPrevalent.begin(), sortedPrevalent.end(), patternOrder);
+    }
+    sortedPrevalent.erase(std::unique(sortedPrevalent.begin(), sortedPrevalent.end(),
+        [](const Colocation* a, const Colocation* b) { return *a == *b; }), sortedPrevalent.end());
+
+    // Join phase: patterns with equal (k-1)-prefix are contiguous, so only pairs inside a
+    // group are joined. Within a group the last features ascend in feature order, so
+    // P_i + last(P_j) (i < j) is already a sorted pattern and the candidates come out
+    // sorted and unique.
+    for (size_t groupBegin = 0; groupBegin < sortedPrevalent.size();) {
+        const Colocation& first = *sortedPrevalent[groupBegin];
+        size_t groupEnd = groupBegin + 1;
+        while (groupEnd < sortedPrevalent.size() &&
+               std::equal(first.begin(), first.end() - 1, sortedPrevalent[groupEnd]->begin())) {
+            ++groupEnd;
+        }
 
-            // Just join when the prefix is equal
-            if (prefix1 != prefix2) {
-                continue;
+        for (size_t firstPatternIdx = groupBegin; firstPatternIdx < groupEnd; ++firstPatternIdx) {
+            for (size_t secondPatternIdx = firstPatternIdx + 1; secondPatternIdx < groupEnd; ++secondPatternIdx) {
+                Colocation candidate;
+                candidate.reserve(first.size() + 1);
+                candidate = *sortedPrevalent[firstPatternIdx];
+                candidate.push_back(sortedPrevalent[secondPatternIdx]->back());
+                candidates.push_back(std::move(candidate));
             }
-            
-            // Generate new candidate
-			Colocation candidate;
-            if (featureCount.at(prevPrevalent[firstPatternIdx].back()) <= featureCount.at(prevPrevalent[secondPatternIdx].back())) {
-                candidate = prevPrevalent[firstPatternIdx];
-                candidate.push_back(prevPrevalent[secondPatternIdx].back());
-            }else {
-				candidate = prevPrevalent[secondPatternIdx];
-				candidate.push_back(prevPrevalent[firstPatternIdx].back());
-            }
-            
-            candidates.push_back(candidate);
         }
+        groupBegin = groupEnd;
     }
 
-    // Remove duplication
-    std::sort(candidates.begin(), candidates.end());
-    candidates.erase(std::unique(candidates.begin(), candidates.end()),
-        candidates.end());
-
     return candidates;
 }
 
 
 std::vector<Colocation> JoinlessMiner::filterCandidates(
     const std::vector<Colocation>& candidates,
-    const std::vector<Colocation>& prevPrevalent,
-	const std::map<Colocation, std::vector<ColocationInstance>>& tableInstance,
+    const PatternMetricsStore& prevMetrics,
     double minPrev,
-    std::map<FeatureType, int> featureCount,
+    const FeatureRanking& featureRanking,
     double delta)
 {
     // Implementation of filter_candidate_patterns (Step 9)
-    std::vector<Colocation> filteredCandidates;
-    if (candidates.empty() || prevPrevalent.empty()) {
-        return filteredCandidates;
+    if (candidates.empty() || prevMetrics.empty()) {
+        return {};
     }
-    std::vector<Colocation> sortedPrev = prevPrevalent;
-    std::sort(sortedPrev.begin(), sortedPrev.end());
-    for (const auto& candidate : candidates) {
-        bool isValid = true;
-        // Generate all (k-1)-size subsets
-        for (size_t featureIndexToRemove = 0; featureIndexToRemove < candidate.size(); featureIndexToRemove++) {
-            Colocation subset;
-            for (size_t j = 0; j < candidate.size(); j++) {
-                if (j != featureIndexToRemove) subset.push_back(candidate[j]);
-            }
-
-            // --- CASE 1: Subset contains f_min (Lemma 2) ---
-            // If we removed an element at index i != 0, the subset still keeps candidate[0] (f_min).
-            if (featureIndexToRemove != 0) {
-                // Lemma 2: If a subset containing f_min is NOT prevalent, C is not prevalent 
-                if (!std::binary_search(sortedPrev.begin(), sortedPrev.end(), subset)) {
-                    isValid = false;
-                    break; // Prune immediately
-                }
-            }
 
-            // --- CASE 2: Subset does NOT contain f_min (Lemma 3) ---
-            // This happens when i == 0 (we removed f_min). Subset is {f2, ..., fk}.
-            else {
-                // Lemma 3: Check upper bound condition 
-                // Condition: PI(subset) * w(f_max, C) < min_prev => Prune
+    // Weight table of the current run; rebuilt when filterCandidates is used on its own
+    // with another ranking or delta than the table was built from
+    if (!rareWeights.builtFrom(featureRanking.features(), featureRanking.counts(), delta)) {
+        rareWeights = RareWeightTable(featureRanking.features(), featureRanking.counts(), delta);
+    }
 
-                // 1. Find f_max (feature with max instances in C)
-                // Assuming sorted input, f_max is the last element
-                FeatureType f_max = candidate.back();
+    // Narrowest mask that holds every feature (bit of a feature = its rank)
+    const size_t numFeatures = featureRanking.size();
+    if (numFeatures <= FeatureMask<1>::capacity()) {
+        return filterCandidatesWithMasks<FeatureMask<1>>(candidates, prevMetrics, minPrev, featureRanking);
+    }
+    if (numFeatures <= FeatureMask<2>::capacity()) {
+        return filterCandidatesWithMasks<FeatureMask<2>>(candidates, prevMetrics, minPrev, featureRanking);
+    }
+    return filterCandidatesWithMasks<DynamicFeatureMask>(candidates, prevMetrics, minPrev, featureRanking);
+}
 
-                // 2. Calculate Weight w(f_max, C) = 1 / RI(f_max, C) 
-                double RI = calculateRareIntensity(f_max, candidate, featureCount, delta);
-                double w = 1.0 / RI;
 
-                // 3. Get PI of the subset (needs to be looked up from previous results)
-                double piSubset = calculatePI(subset, tableInstance, featureCount);
+template <typename Mask>
+std::vector<Colocation> JoinlessMiner::filterCandidatesWithMasks(
+    const std::vector<Colocation>& candidates,
+    const PatternMetricsStore& prevMetrics,
+    double minPrev,
+    const FeatureRanking& featureRanking)
+{
+    // Every (k-1)-pattern evaluated at the previous level, prevalent or not, in an
+    // open-addressing hash map to its metrics
+    const std::vector<Colocation>& prevPatterns = prevMetrics.patterns();
+    MaskHashMap<Mask> metricsIndex(prevPatterns.size(), featureRanking.size());
+    for (size_t i = 0; i < prevPatterns.size(); ++i) {
+        metricsIndex.insert(patternMask<Mask>(prevPatterns[i], featureRanking), i);
+    }
 
-                // Check Lemma 3 inequality
-                if (piSubset * w < minPrev) {
-                    isValid = false;
-                    break; // Prune
-                }
-            }
-        }
-        if (isValid) {
+    std::vector<Colocation> filteredCandidates;
+    for (const auto& candidate : candidates) {
+        if (passesSubsetPruning(candidate, metricsIndex, prevMetrics, minPrev, featureRanking)) {
             filteredCandidates.push_back(candidate);
         }
     }
     return filteredCandidates;
 }
 
+
+template <typename Mask>
+bool JoinlessMiner::passesSubsetPruning(
+    const Colocation& candidate,
+    const MaskHashMap<Mask>& metricsIndex,
+    const PatternMetricsStore& metrics,
+    double minPrev,
+    const FeatureRanking& featureRanking) const
+{
+    Mask candidateMask = patternMask<Mask>(candidate, featureRanking);
+
+    // --- CASE 1: Subsets containing f_min (Lemma 2) ---
+    // Removing any feature but candidate[0] (f_min) keeps f_min in the subset.
+    // If such a subset is NOT prevalent, C is not prevalent.
+    for (size_t featureIndexToRemove = 1; featureIndexToRemove < candidate.size(); featureIndexToRemove++) {
+        const size_t bit = featureRanking.rank(candidate[featureIndexToRemove]);
+        candidateMask.reset(bit);
+        const size_t subsetIndex = metricsIndex.find(candidateMask);
+        candidateMask.set(bit);
+        if (subsetIndex == MaskHashMap<Mask>::NOT_FOUND || !metrics.metrics(subsetIndex).prevalent) {
+            return false; // Prune immediately
+        }
+    }
+
+    // --- CASE 2: Subset without f_min (Lemma 3) ---
+    // Condition: PI(subset) * w(f_max, C) < min_prev => Prune
+    // 1. Find f_max (feature with max instances in C)
+    // Assuming sorted input, f_max is the last element and f_min the first
+    const size_t maxBit = featureRanking.rank(candidate.back());
+    const size_t minBit = featureRanking.rank(candidate.front());
+
+    // 2. Weight w(f_max, C) = 1 / RI(f_max, C) from the precomputed table
+    // (0 stands for RI ~ 0, i.e. an unbounded weight that cannot prune)
+    const double w = rareWeights.weight(maxBit, minBit);
+
+    // 3. PI of the subset, recorded when it was evaluated
+    // (a subset that was never evaluated was pruned before, so it has no participants)
+    candidateMask.reset(minBit);
+    const size_t subsetIndex = metricsIndex.find(candidateMask);
+    const double piSubset = (subsetIndex != MaskHashMap<Mask>::NOT_FOUND)
+        ? metrics.metrics(subsetIndex).participationIndex
+        : 0.0;
+
+    // Check Lemma 3 inequality
+    return !(w > 0.0 && piSubset * w < minPrev);
+}
+
 // Helper function to find neighbors of an instance for a specific feature type from NRTree
-// Returns Neigh(o, f) - all neighbors of instance o that have feature type f
+// Returns Neigh(o, f) - all neighbors of instance o that have feature type f (sorted by ordinal)
 std::vector<const SpatialInstance*> JoinlessMiner::findNeighbors(
     const NRTree& tree,
     const SpatialInstance* instance,
     const FeatureType& featureType
 ) {
-    std::vector<const SpatialInstance*> result;
-    const NRNode* root = tree.getRoot();
-    if (!root) return result;
-
-    // Traverse NRTree structure:
-    // Level 1: FEATURE_NODE (center features)
-    // Level 2: INSTANCE_NODE (center instances)
-    // Level 3: FEATURE_NODE (neighbor features)
-    // Level 4: INSTANCE_VECTOR_NODE (neighbor instances)
-
-    // Find the feature node for the instance's feature type (Level 1)
-    for (const auto* featureNode : root->children) {
-        if (featureNode->type == FEATURE_NODE && featureNode->featureType == instance->type) {
-            // Find the instance node for this specific instance (Level 2)
-            for (const auto* instanceNode : featureNode->children) {
-                if (instanceNode->type == INSTANCE_NODE && instanceNode->data->id == instance->id) {
-                    // Find the neighbor feature node for the target feature type (Level 3)
-                    for (const auto* neighborFeatureNode : instanceNode->children) {
-                        if (neighborFeatureNode->type == FEATURE_NODE && 
-                            neighborFeatureNode->featureType == featureType) {
-                            // Get the instance vector node (Level 4)
-                            if (!neighborFeatureNode->children.empty()) {
-                                const auto* instanceVectorNode = neighborFeatureNode->children[0];
-                                if (instanceVectorNode->type == INSTANCE_VECTOR_NODE) {
-                                    // Return all neighbor instances
-                                    return instanceVectorNode->instanceVector;
-                                }
-                            }
-                        }
-                    }
-                }
+    // Level 2: INSTANCE_NODE of the instance, found through the tree's star index
+    const NRNode* instanceNode = tree.findStar(instance);
+    if (!instanceNode) return {};
+
+    // Level 3: FEATURE_NODE of the target feature type -> Level 4: INSTANCE_VECTOR_NODE
+    for (const auto* neighborFeatureNode : instanceNode->children) {
+        if (neighborFeatureNode->type == FEATURE_NODE &&
+            neighborFeatureNode->featureType == featureType &&
+            !neighborFeatureNode->children.empty()) {
+            const auto* instanceVectorNode = neighborFeatureNode->children[0];
+            if (instanceVectorNode->type == INSTANCE_VECTOR_NODE) {
+                return instanceVectorNode->instanceVector;
             }
         }
     }
 
-    return result;
+    return {};
 }
 
 // Helper function to calculate S(I, f) = Neigh(o1, f) ∩ ··· ∩ Neigh(ok, f) (Definition 8)
 // Returns the intersection of neighbors for all instances in I with feature type f
+// Used when no extension sets are carried for the prefix; the incremental path in
+// genTableInstance needs a single intersection per row instead
 std::vector<const SpatialInstance*> JoinlessMiner::findExtendedSet(
     const NRTree& tree,
     const ColocationInstance& instance,
@@ -273,158 +555,788 @@ std::vector<const SpatialInstance*> JoinlessMiner::findExtendedSet(
     // Start with neighbors of the first instance
     std::vector<const SpatialInstance*> intersection = findNeighbors(tree, instance[0], featureType);
 
-    // Intersect with neighbors of remaining instances
-    for (size_t i = 1; i < instance.size(); i++) {
-        std::vector<const SpatialInstance*> neighbors = findNeighbors(tree, instance[i], featureType);
+    // Intersect with neighbors of remaining instances (all lists are sorted by ordinal)
+    for (size_t i = 1; i < instance.size() && !intersection.empty(); i++) {
+        intersection = intersectByOrdinal(intersection, findNeighbors(tree, instance[i], featureType));
+    }
+
+    return intersection;
+}
+
+std::map<Colocation, PackedTable> JoinlessMiner::genTableInstance(
+    const std::vector<Colocation>& candidates,
+    const std::map<Colocation, PackedTable>& prevTableInstances,
+    const std::map<Colocation, ExtensionTable>& prevExtensions,
+    const SpilledTables* prevSpilled,
+    const NRTree& orderedNRTree,
+    double minPrev,
+    bool countOnly,
+    size_t budgetBytes,
+    std::unique_ptr<SpilledTables>& spilled,
+    size_t& heldBytes,
+    LevelArena& arena,
+    std::map<Colocation, ExtensionTable>& extensions,
+    std::map<Colocation, PatternMetrics>& participation
+) {
+    std::map<Colocation, PackedTable> result;
+    extensions.clear();
+    participation.clear();
 
-        if (neighbors.empty()) {
-            return {}; // Một ông không có neighbor thì giao bằng rỗng luôn
+    // 1. Group candidates by prefix (k-1 features): prefix -> new features, in candidate order
+    std::map<Colocation, std::vector<FeatureType>> prefixGroups;
+    for (const auto& candidate : candidates) {
+        // --- [DEBUG 1] Kiểm tra candidate rỗng ---
+        if (candidate.empty()) {
+            if (debugOutput) std::cout << "[DEBUG] SKIP: Candidate is empty.\n";
+            continue;
         }
+        prefixGroups[Colocation(candidate.begin(), candidate.end() - 1)].push_back(candidate.back());
+    }
 
-        // --- [SỬA TẠI ĐÂY] ---
-        // Dùng ID để tạo bảng tra cứu (Lookup Table)
-        // Giả sử ID là int hoặc string đều dùng được cách này
-        std::set<decltype(instance[0]->id)> neighborIDs;
-        for (const auto* ptr : neighbors) {
-            neighborIDs.insert(ptr->id);
+    std::vector<std::map<Colocation, std::vector<FeatureType>>::const_iterator> groups;
+    for (auto groupIt = prefixGroups.cbegin(); groupIt != prefixGroups.cend(); ++groupIt) {
+        groups.push_back(groupIt);
+    }
+
+    // 2. Extend every prefix once for all of its new features (prefix groups are independent)
+    std::vector<std::vector<PackedTable>> groupRows(groups.size());
+    std::vector<std::vector<ExtensionTable>> groupExtensions(groups.size());
+    std::vector<std::vector<PatternMetrics>> groupMetrics(groups.size());
+    std::vector<size_t> prefixRowCounts(groups.size(), SIZE_MAX);  // SIZE_MAX: prefix table not found
+    std::vector<std::vector<char>> groupSpilled(groups.size());      // Tables written to spilled
+    for (size_t g = 0; g < groups.size(); ++g) groupSpilled[g].assign(groups[g]->second.size(), 0);
+    heldBytes = 0;                                                   // Tables of the level kept in memory
+    std::atomic<bool> overBudget(false);                             // A table of the level was spilled
+    const std::vector<FeatureType> noKeptFeatures;
+    std::exception_ptr loadError;                                    // Exceptions cannot leave the parallel loop
+
+    // At most one thread per arena of the level (the team may differ from the arena's)
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(static_cast<int>(arena.threads()))
+    for (long long g = 0; g < static_cast<long long>(groups.size()); ++g) {
+        const Colocation& prefix = groups[g]->first;
+        TRACE_SCOPE("extend " + patternName(prefix) + " x" + std::to_string(groups[g]->second.size()));
+        const auto tableIt = prevTableInstances.find(prefix);
+
+        // Spilled prefixes are streamed back in; their extension sets are recomputed
+        PackedTable loadedRows;
+        const PackedTable* prefixRows = nullptr;
+        if (tableIt != prevTableInstances.end()) {
+            prefixRows = &tableIt->second;
         }
+        else if (prevSpilled && prevSpilled->contains(prefix)) {
+            try {
+                loadedRows = prevSpilled->load(prefix);
+            }
+            catch (...) {
+                #pragma omp critical(spill_load_error)
+                if (!loadError) loadError = std::current_exception();
+                continue;
+            }
+            prefixRows = &loadedRows;
+        }
+        if (!prefixRows) continue;
+        prefixRowCounts[g] = prefixRows->size();
+
+        // Once the level is over budget, later groups carry no extension sets: most of their
+        // tables go to disk, and the sets of spilled tables would stay in the arena
+        const auto extIt = prevExtensions.find(prefix);
+        extendPrefix(prefix, *prefixRows,
+            (extIt != prevExtensions.end()) ? &extIt->second : nullptr,
+            groups[g]->second, orderedNRTree, minPrev, countOnly, arena.local(),
+            groupRows[g], groupExtensions[g], groupMetrics[g], overBudget ? &noKeptFeatures : nullptr);
+        if (countOnly) continue;
+
+        // Keep the finished tables of the group while the level fits into the budget;
+        // once it is crossed, write them to disk instead (their extension sets are dropped
+        // and recomputed when the table is read back as a prefix)
+        std::vector<size_t> tableBytes(groups[g]->second.size(), 0);
+        for (size_t f = 0; f < tableBytes.size(); ++f) {
+            if (!groupMetrics[g][f].exact || groupRows[g][f].empty()) continue;
+            const ExtensionTable& ext = groupExtensions[g][f];
+            tableBytes[f] = estimateTableBytes(groupRows[g][f], (ext.sets.size() == groupRows[g][f].size()) ? &ext : nullptr);
+        }
+        #pragma omp critical(level_budget)
+        {
+            for (size_t f = 0; f < tableBytes.size(); ++f) {
+                if (tableBytes[f] == 0) continue;
+                if (budgetBytes != 0 && heldBytes + tableBytes[f] > budgetBytes) {
+                    Colocation candidate = prefix;
+                    candidate.push_back(groups[g]->second[f]);
+                    if (!spilled) spilled.reset(new SpilledTables());
+                    if (spilled->spill(candidate, groupRows[g][f])) {
+                        groupRows[g][f] = PackedTable();
+                        groupExtensions[g][f] = ExtensionTable(arena.local());
+                        groupSpilled[g][f] = 1;
+                        overBudget = true;
+                        continue;
+                    }
+                }
+                heldBytes += tableBytes[f];
+            }
+        }
+    }
 
-        std::vector<const SpatialInstance*> newIntersection;
+    // A prefix table that cannot be read back would silently lose its candidates
+    if (loadError) std::rethrow_exception(loadError);
 
-        // Chỉ giữ lại những thằng trong intersection có ID nằm trong neighborIDs
-        for (const auto* ptr : intersection) {
-            if (neighborIDs.count(ptr->id)) {
-                newIntersection.push_back(ptr);
+    // 3. Collect results per candidate
+    for (size_t g = 0; g < groups.size(); ++g) {
+        const Colocation& prefix = groups[g]->first;
+        const std::vector<FeatureType>& newFeatures = groups[g]->second;
+
+        // --- [DEBUG 2] Kiểm tra Prefix (quan trọng nhất cho lỗi size 2) ---
+        if (prefixRowCounts[g] == SIZE_MAX) {
+            for (size_t f = 0; f < newFeatures.size() && debugOutput; ++f) {
+                std::cout << " NOT FOUND in prevTableInstances.\n";
             }
+            continue;
         }
 
-        intersection = std::move(newIntersection);
+        // --- [DEBUG 3] Prefix tồn tại nhưng không có instance nào ---
+        if (prefixRowCounts[g] == 0) {
+            for (size_t f = 0; f < newFeatures.size() && debugOutput; ++f) {
+                std::cout << ". Reason: Prefix found but has 0 instances.\n";
+            }
+            continue;
+        }
 
-        // Early termination if intersection becomes empty
-        if (intersection.empty()) {
-            break;
+        for (size_t f = 0; f < newFeatures.size(); ++f) {
+            Colocation candidate = prefix;
+            candidate.push_back(newFeatures[f]);
+
+            // Store results
+            const bool abandoned = !groupMetrics[g][f].exact;
+            participation[candidate] = std::move(groupMetrics[g][f]);
+            PackedTable& rows = groupRows[g][f];
+            if (abandoned || countOnly || groupSpilled[g][f]) {
+                continue; // Stopped early (cannot reach minPrev), count-only level or on disk
+            }
+            if (!rows.empty()) {
+                // Extension sets exist only if they were carried for every row (emplace
+                // moves them: assigning into a default-constructed table would copy them
+                // out of the arena)
+                if (groupExtensions[g][f].sets.size() == rows.size()) {
+                    extensions.emplace(candidate, std::move(groupExtensions[g][f]));
+                }
+                result.emplace(candidate, std::move(rows));
+            }
+            else if (debugOutput) {
+                std::cout << " processed but NO instances generated (No neighbors satisfy distance).\n";
+            }
         }
     }
+    return result;
+}
 
-    return intersection;
+
+void JoinlessMiner::extendPrefix(
+    const Colocation& prefix,
+    const PackedTable& prefixRows,
+    const ExtensionTable* prefixExt,
+    const std::vector<FeatureType>& newFeatures,
+    const NRTree& orderedNRTree,
+    double minPrev,
+    bool countOnly,
+    std::pmr::memory_resource* resource,
+    std::vector<PackedTable>& rowsPerFeature,
+    std::vector<ExtensionTable>& extensionsPerFeature,
+    std::vector<PatternMetrics>& metricsPerFeature,
+    const std::vector<FeatureType>* keepFeatures
+) {
+    dispatchRowWidth(prefix.size() + 1, [&](auto width) {
+        extendPrefixRows<decltype(width)::value>(prefix, prefixRows, prefixExt, newFeatures, orderedNRTree,
+            minPrev, countOnly, resource, rowsPerFeature, extensionsPerFeature, metricsPerFeature, keepFeatures);
+    });
 }
 
-std::map<Colocation, std::vector<ColocationInstance>> JoinlessMiner::genTableInstance(
-    const std::vector<Colocation>& candidates,
-    const std::map<Colocation, std::vector<ColocationInstance>>& prevTableInstances,
-    const NRTree& orderedNRTree
+
+template <size_t Width>
+void JoinlessMiner::extendPrefixRows(
+    const Colocation& prefix,
+    const PackedTable& prefixRows,
+    const ExtensionTable* prefixExt,
+    const std::vector<FeatureType>& newFeatures,
+    const NRTree& orderedNRTree,
+    double minPrev,
+    bool countOnly,
+    std::pmr::memory_resource* resource,
+    std::vector<PackedTable>& rowsPerFeature,
+    std::vector<ExtensionTable>& extensionsPerFeature,
+    std::vector<PatternMetrics>& metricsPerFeature,
+    const std::vector<FeatureType>* keepFeatures
 ) {
-    std::map<Colocation, std::vector<ColocationInstance>> result;
+    const size_t numFeatures = newFeatures.size();
+    // A compile-time constant for fixed widths, so the loops over positions unroll
+    const size_t prefixSize = (Width == DYNAMIC_ROW_WIDTH) ? prefix.size() : Width - 1;
+    const size_t numRows = prefixRows.size();
+    std::vector<TableInstance<Width>> newRows(numFeatures, TableInstance<Width>(prefixSize + 1));
+    extensionsPerFeature.clear();
+    extensionsPerFeature.reserve(numFeatures);
+    for (size_t f = 0; f < numFeatures; ++f) extensionsPerFeature.emplace_back(resource);
+    metricsPerFeature.assign(numFeatures, {});
+
+    // Slot of S(I, f) among the carried sets of each new feature f (SIZE_MAX: not carried),
+    // and the sets the new rows keep: features after f that extend this prefix as well
+    std::vector<size_t> newFeatureSlot(numFeatures, SIZE_MAX);
+    std::vector<std::vector<size_t>> keptSlots(numFeatures);
+    std::vector<std::vector<size_t>> keptRanks(numFeatures);
+    if (prefixExt) {
+        for (size_t f = 0; f < numFeatures; ++f) {
+            const auto slotIt = std::find(prefixExt->features.begin(), prefixExt->features.end(), newFeatures[f]);
+            if (slotIt != prefixExt->features.end()) {
+                newFeatureSlot[f] = static_cast<size_t>(slotIt - prefixExt->features.begin());
+            }
+        }
+        // Slots of the features whose sets the new rows may keep: the other new features,
+        // or the given keepFeatures
+        std::vector<size_t> candidateSlots = newFeatureSlot;
+        if (keepFeatures) {
+            candidateSlots.clear();
+            for (const auto& feature : *keepFeatures) {
+                const auto slotIt = std::find(prefixExt->features.begin(), prefixExt->features.end(), feature);
+                if (slotIt != prefixExt->features.end()) {
+                    candidateSlots.push_back(static_cast<size_t>(slotIt - prefixExt->features.begin()));
+                }
+            }
+        }
+        for (size_t f = 0; f < numFeatures; ++f) {
+            if (newFeatureSlot[f] == SIZE_MAX) continue;
+            for (const size_t slot : candidateSlots) {
+                if (slot != SIZE_MAX && slot > newFeatureSlot[f]) {
+                    keptSlots[f].push_back(slot);
+                }
+            }
+            std::sort(keptSlots[f].begin(), keptSlots[f].end());
+            for (const size_t slot : keptSlots[f]) {
+                extensionsPerFeature[f].features.push_back(prefixExt->features[slot]);
+                keptRanks[f].push_back(ranking.rank(prefixExt->features[slot]));
+            }
+        }
+    }
 
-    // Iterate through each candidate pattern C of size k
-    for (const auto& candidate : candidates) {
+    // Instance counts and WPI weights of every position of prefix + f (f_min is prefix[0])
+    const size_t minRank = ranking.rank(prefix.front());
+    std::vector<int> positionCounts(prefixSize);
+    std::vector<double> positionWeights(prefixSize);
+    for (size_t i = 0; i < prefixSize; ++i) {
+        positionCounts[i] = ranking.count(prefix[i]);
+        positionWeights[i] = rareWeights.weight(ranking.rank(prefix[i]), minRank);
+    }
 
-        // --- [DEBUG 1] Kiểm tra candidate rỗng ---
-        if (candidate.empty()) {
-            std::cout << "[DEBUG] SKIP: Candidate is empty.\n";
-            continue;
+    // Bounds are only checked every PR_BOUND_CHECK_INTERVAL rows, so the suffix counts are
+    // kept at those checkpoints only. remainingDistinct[i * checkpoints + c]: distinct
+    // instances at position i in the prefix rows from c * PR_BOUND_CHECK_INTERVAL on — at
+    // most that many prefix instances can still start participating. One backward pass
+    // per position fills it.
+    const size_t checkInterval = Constants::PR_BOUND_CHECK_INTERVAL;
+    const size_t checkpoints = numRows / checkInterval + 1;
+    std::vector<uint32_t> remainingDistinct(prefixSize * checkpoints, 0);
+    for (size_t i = 0; i < prefixSize; ++i) {
+        InstanceBitmap seen(static_cast<size_t>(positionCounts[i]));
+        uint32_t distinct = 0;
+        for (size_t r = numRows; r-- > 0;) {
+            const uint32_t ordinal = prefixRows.row(r)[i];
+            if (!seen.test(ordinal)) {
+                seen.set(ordinal);
+                ++distinct;
+            }
+            if (r % checkInterval == 0) remainingDistinct[i * checkpoints + r / checkInterval] = distinct;
         }
+    }
 
-        // 1. Split candidate into prefix (k-1 features) and the new feature
-        Colocation subPattern(candidate.begin(), candidate.end() - 1);
-        FeatureType newFeature = candidate.back();
+    // remainingExtensions[f]: sum of |S(I, f)| over the prefix rows not processed yet (carried
+    // sets only); starts at the total and is counted down while the rows are extended
+    std::vector<size_t> remainingExtensions(numFeatures, 0);
+    for (size_t f = 0; f < numFeatures; ++f) {
+        if (newFeatureSlot[f] == SIZE_MAX) continue;
+        for (size_t r = 0; r < numRows; ++r) {
+            remainingExtensions[f] += prefixExt->sets[r][newFeatureSlot[f]].size();
+        }
+        // The carried sets give the exact row count: nothing is regrown (the arena does not
+        // reclaim outgrown buffers)
+        if (!countOnly) {
+            newRows[f].reserve(remainingExtensions[f]);
+            if (!keptSlots[f].empty()) extensionsPerFeature[f].sets.reserve(remainingExtensions[f]);
+        }
+    }
 
-        // 2. Fast lookup: Find existing instances of the prefix pattern
-        auto it = prevTableInstances.find(subPattern);
+    // Participation bitmaps of every position of prefix + f, filled while generating
+    std::vector<std::vector<InstanceBitmap>> participants(numFeatures);
+    std::vector<std::vector<size_t>> participantCounts(numFeatures, std::vector<size_t>(prefixSize + 1, 0));
+    std::vector<int> newCounts(numFeatures);
+    std::vector<double> newWeights(numFeatures);
+    std::vector<size_t> generatedRows(numFeatures, 0);
+    std::vector<bool> alive(numFeatures, true);
+    size_t aliveCount = numFeatures;
+    for (size_t f = 0; f < numFeatures; ++f) {
+        newCounts[f] = ranking.count(newFeatures[f]);
+        newWeights[f] = rareWeights.weight(ranking.rank(newFeatures[f]), minRank);
+        for (size_t i = 0; i < prefixSize; ++i) participants[f].emplace_back(positionCounts[i]);
+        participants[f].emplace_back(newCounts[f]);
+    }
 
-        // --- [DEBUG 2] Kiểm tra Prefix (quan trọng nhất cho lỗi size 2) ---
-        if (it == prevTableInstances.end()) {
-            std::cout << " NOT FOUND in prevTableInstances.\n";
+    // Upper bound of each PR of prefix + f after the first processedRows prefix rows
+    // (a multiple of PR_BOUND_CHECK_INTERVAL)
+    const auto prBounds = [&](size_t f, size_t processedRows) {
+        std::vector<double> bounds(prefixSize + 1, 1.0);
+        for (size_t i = 0; i < prefixSize; ++i) {
+            const uint32_t remaining = remainingDistinct[i * checkpoints + processedRows / checkInterval];
+            const double reachable = static_cast<double>(participantCounts[f][i] + remaining);
+            bounds[i] = std::min(1.0, reachable / positionCounts[i]);
+        }
+        if (newFeatureSlot[f] != SIZE_MAX) {
+            const double reachable = static_cast<double>(participantCounts[f][prefixSize] + remainingExtensions[f]);
+            bounds[prefixSize] = std::min(1.0, reachable / newCounts[f]);
+        }
+        return bounds;
+    };
+
+    // Visit every prefix row once and extend it with all new features
+    ColocationInstance prevInstance(prefixSize);
+    for (size_t rowIdx = 0; rowIdx < numRows && aliveCount > 0; ++rowIdx) {
+        const uint32_t* prevRow = prefixRows.row(rowIdx);
+        bool prevInstanceResolved = false;
+
+        for (size_t f = 0; f < numFeatures; ++f) {
+            if (!alive[f]) continue;
+
+            // S(I, f): carried with the prefix row, or recomputed from scratch if not carried
+            // (the instances of the row are then resolved from their ordinals)
+            ExtensionTable::InstanceSet recomputedSet;
+            if (newFeatureSlot[f] == SIZE_MAX) {
+                if (!prevInstanceResolved) {
+                    for (size_t i = 0; i < prefixSize; ++i) prevInstance[i] = instanceLookup.find(prefix[i], prevRow[i]);
+                    prevInstanceResolved = true;
+                }
+                const auto found = findExtendedSet(orderedNRTree, prevInstance, newFeatures[f]);
+                recomputedSet.assign(found.begin(), found.end());
+            }
+            const ExtensionTable::InstanceSet& extendedSet = (newFeatureSlot[f] == SIZE_MAX)
+                ? recomputedSet
+                : prefixExt->sets[rowIdx][newFeatureSlot[f]];
+
+            // The prefix instances participate as soon as the row extends at all
+            std::vector<InstanceBitmap>& bitmaps = participants[f];
+            if (!extendedSet.empty()) {
+                for (size_t i = 0; i < prefixSize; ++i) {
+                    if (!bitmaps[i].test(prevRow[i])) {
+                        bitmaps[i].set(prevRow[i]);
+                        ++participantCounts[f][i];
+                    }
+                }
+            }
+
+            // Create new instances together with S(I ∪ {o}, g) = S(I, g) ∩ Neigh(o, g)
+            ExtensionTable& newExt = extensionsPerFeature[f];
+            generatedRows[f] += extendedSet.size();
+            if (newFeatureSlot[f] != SIZE_MAX) remainingExtensions[f] -= extendedSet.size();
+            for (const auto* neighbor : extendedSet) {
+                if (!bitmaps[prefixSize].test(neighbor->ordinal)) {
+                    bitmaps[prefixSize].set(neighbor->ordinal);
+                    ++participantCounts[f][prefixSize];
+                }
+                if (countOnly) continue; // Only participation is needed
+
+                newRows[f].pushExtended(prevRow, neighbor->ordinal);
 
-            // Gợi ý lỗi cụ thể nếu đang chạy k=2
-            if (candidate.size() == 2) {
-                std::cout << "    -> HINT: For k=2, prevTableInstances must contain size-1 patterns (e.g., {'A'}). Did you initialize T1 correctly?\n";
+                if (keptSlots[f].empty()) continue; // No set to keep: the table carries none
+                const auto neighborSets = starNeighborSets(orderedNRTree.findStar(neighbor), newExt.features, keptRanks[f]);
+                std::pmr::vector<ExtensionTable::InstanceSet> rowSets(newExt.features.size(), resource);
+                for (size_t j = 0; j < rowSets.size(); ++j) {
+                    if (neighborSets[j]) {
+                        intersectByOrdinal(prefixExt->sets[rowIdx][keptSlots[f][j]], *neighborSets[j], rowSets[j]);
+                    }
+                }
+                newExt.sets.push_back(std::move(rowSets));
             }
-            continue;
         }
 
-        std::vector<ColocationInstance> newTableRows;
-        const std::vector<ColocationInstance>& prevInstancesList = it->second;
+        // Periodically drop candidates whose weighted PR bound can no longer reach minPrev
+        if ((rowIdx + 1) % Constants::PR_BOUND_CHECK_INTERVAL != 0 || rowIdx + 1 == numRows) continue;
+        for (size_t f = 0; f < numFeatures; ++f) {
+            if (!alive[f]) continue;
+            const std::vector<double> bounds = prBounds(f, rowIdx + 1);
+            double wpiBound = bounds[prefixSize] * newWeights[f];
+            for (size_t i = 0; i < prefixSize; ++i) {
+                wpiBound = std::min(wpiBound, bounds[i] * positionWeights[i]);
+            }
+            if (wpiBound >= minPrev) continue;
+
+            alive[f] = false;
+            --aliveCount;
+            PatternMetrics& metrics = metricsPerFeature[f];
+            metrics.participationRatios = bounds;
+            metrics.rowCount = generatedRows[f];
+            metrics.exact = false;
+            newRows[f].release();
+            extensionsPerFeature[f] = ExtensionTable(resource);
+        }
+    }
 
-        // --- [DEBUG 3] Prefix tồn tại nhưng không có instance nào ---
-        if (prevInstancesList.empty()) {
-            std::cout << ". Reason: Prefix found but has 0 instances.\n";
-            continue;
+    // Exact PRs of the candidates that were generated completely
+    for (size_t f = 0; f < numFeatures; ++f) {
+        if (!alive[f]) continue;
+        PatternMetrics& metrics = metricsPerFeature[f];
+        metrics.participationRatios.resize(prefixSize + 1);
+        for (size_t i = 0; i < prefixSize; ++i) {
+            metrics.participationRatios[i] = static_cast<double>(participantCounts[f][i]) / positionCounts[i];
         }
+        metrics.participationRatios[prefixSize] = static_cast<double>(participantCounts[f][prefixSize]) / newCounts[f];
+        metrics.rowCount = generatedRows[f];
+    }
 
-        // 3. Try to extend each existing instance I with the new feature f
-        for (const auto& prevInstance : prevInstancesList) {
-            // Calculate intersection
-            std::vector<const SpatialInstance*> extendedSet = findExtendedSet(
-                orderedNRTree, prevInstance, newFeature
-            );
+    rowsPerFeature.clear();
+    rowsPerFeature.reserve(numFeatures);
+    for (auto& rows : newRows) rowsPerFeature.emplace_back(std::move(rows));
+}
 
-            // 4. Create new instances
-            for (const auto* neighbor : extendedSet) {
-                ColocationInstance newRow = prevInstance;
-                newRow.push_back(neighbor);
-                newTableRows.push_back(std::move(newRow));
-            }
+
+void JoinlessMiner::trimExtensions(
+    std::map<Colocation, ExtensionTable>& extensions,
+    const std::vector<Colocation>& prevalent
+) {
+    const std::set<Colocation> prevalentSet(prevalent.begin(), prevalent.end());
+
+    for (auto it = extensions.begin(); it != extensions.end();) {
+        if (!prevalentSet.count(it->first)) {
+            it = extensions.erase(it);
+            continue;
         }
 
-        // Store results
-        if (!newTableRows.empty()) {
-            result[candidate] = std::move(newTableRows);
+        // Keep the set of g only if prefix + g is prevalent too
+        ExtensionTable& ext = it->second;
+        Colocation sibling(it->first.begin(), it->first.end() - 1);
+        sibling.push_back(FeatureType());
+        std::vector<size_t> keep;
+        for (size_t j = 0; j < ext.features.size(); ++j) {
+            sibling.back() = ext.features[j];
+            if (prevalentSet.count(sibling)) keep.push_back(j);
         }
-        else {
-            std::cout << " processed but NO instances generated (No neighbors satisfy distance).\n";
+
+        if (keep.size() != ext.features.size()) {
+            std::vector<FeatureType> features;
+            for (const size_t j : keep) features.push_back(ext.features[j]);
+            // Compacted in place: the sets stay in their arena and nothing is allocated
+            for (auto& rowSets : ext.sets) {
+                for (size_t n = 0; n < keep.size(); ++n) {
+                    if (keep[n] != n) rowSets[n] = std::move(rowSets[keep[n]]);
+                }
+                rowSets.resize(keep.size());
+            }
+            ext.features = std::move(features);
         }
+        ++it;
+    }
+}
+
+
+void JoinlessMiner::dropNonPrevalentTables(
+    std::map<Colocation, PackedTable>& tableInstances,
+    const std::vector<Colocation>& prevalent
+) {
+    const std::set<Colocation> prevalentSet(prevalent.begin(), prevalent.end());
+    for (auto it = tableInstances.begin(); it != tableInstances.end();) {
+        if (prevalentSet.count(it->first)) ++it;
+        else it = tableInstances.erase(it);
     }
-    return result;
+}
+
+
+void JoinlessMiner::spillOverBudget(
+    std::map<Colocation, PackedTable>& tableInstances,
+    std::map<Colocation, ExtensionTable>& extensions,
+    size_t budgetBytes,
+    std::unique_ptr<SpilledTables>& spilled
+) {
+    // Bytes held by every table together with its extension sets
+    std::vector<std::pair<size_t, const Colocation*>> tableBytes;
+    size_t totalBytes = 0;
+    for (const auto& entry : tableInstances) {
+        const auto extIt = extensions.find(entry.first);
+        const size_t bytes = estimateTableBytes(entry.second, (extIt != extensions.end()) ? &extIt->second : nullptr);
+        tableBytes.push_back({ bytes, &entry.first });
+        totalBytes += bytes;
+    }
+    if (totalBytes <= budgetBytes) return;
+
+    // Spill the largest tables first until the rest fits
+    std::sort(tableBytes.begin(), tableBytes.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first || (a.first == b.first && *a.second < *b.second);
+    });
+    if (!spilled) spilled.reset(new SpilledTables());
+    for (const auto& entry : tableBytes) {
+        if (totalBytes <= budgetBytes) break;
+        const Colocation pattern = *entry.second;
+        if (!spilled->spill(pattern, tableInstances.at(pattern))) break;
+        tableInstances.erase(pattern);
+        extensions.erase(pattern);
+        totalBytes -= entry.first;
+    }
+}
+
+
+void JoinlessMiner::compactExtensions(
+    std::map<Colocation, ExtensionTable>& extensions,
+    std::unique_ptr<LevelArena>& arena
+) {
+    size_t keptBytes = 0;
+    for (const auto& entry : extensions) keptBytes += estimateTableBytes(PackedTable(), &entry.second);
+    if (arena->bytesReserved() <= 2 * keptBytes) return;
+
+    // Copies are built from the new arena (a table assigned across arenas would be copied
+    // into the old one); the old tables go before their arena does
+    auto compacted = std::make_unique<LevelArena>();
+    std::map<Colocation, ExtensionTable> copies;
+    for (const auto& entry : extensions) {
+        ExtensionTable& copy = copies.emplace(entry.first, ExtensionTable(compacted->local())).first->second;
+        copy.features = entry.second.features;
+        copy.sets.assign(entry.second.sets.begin(), entry.second.sets.end());
+    }
+    extensions = std::move(copies);
+    arena = std::move(compacted);
+}
+
+
+size_t JoinlessMiner::levelTableBytes(
+    const std::map<Colocation, PackedTable>& tableInstances,
+    const std::map<Colocation, ExtensionTable>& extensions
+) const {
+    size_t bytes = 0;
+    for (const auto& entry : tableInstances) {
+        const auto extIt = extensions.find(entry.first);
+        bytes += estimateTableBytes(entry.second, (extIt != extensions.end()) ? &extIt->second : nullptr);
+    }
+    return bytes;
 }
 
 
 std::vector<Colocation> JoinlessMiner::selectPrevColocations(
     const std::vector<Colocation>& candidates,
-    const std::map<Colocation, std::vector<ColocationInstance>>& tableInstances,
+    const std::map<Colocation, PatternMetrics>& participation,
     double minPrev,
-    const std::map<FeatureType, int>& featureCount,
-    double delta
+    PatternMetricsStore& metricsStore
 ) {
     std::vector<Colocation> prevalentPatterns;
+    std::vector<PatternMetrics> candidateMetrics(candidates.size());
 
-    for (const auto& candidate : candidates) {
-        // Init WPI with a safe max value
-        double wpi = 1.0;
-        bool isFirstFeature = true;
-
-        for (const FeatureType& feature : candidate) {
-            double pr = calculatePR(feature, candidate, tableInstances, featureCount);
-            double ri = calculateRareIntensity(feature, candidate, featureCount, delta);
-
-            // Safety check for RI
-            double weight = 0.0;
-            if (ri > Constants::EPSILON_SMALL) { // Epsilon check
-                weight = 1.0 / ri;
-            }
-            else {
-                // If RI is 0 (should imply feature not in pattern or error), weight is huge or handled
-                weight = 0.0;
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        // Candidates without an entry had no prefix rows: every PR is 0
+        const auto it = participation.find(candidates[c]);
+        if (it != participation.end()) {
+            candidateMetrics[c] = it->second;
+        }
+        else {
+            candidateMetrics[c].participationRatios.assign(candidates[c].size(), 0.0);
+        }
+    }
+
+    // Check threshold
+    fillPrevalence(candidates, candidateMetrics, minPrev);
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        if (candidateMetrics[c].prevalent) {
+            prevalentPatterns.push_back(candidates[c]);
+        }
+        metricsStore.add(candidates[c], std::move(candidateMetrics[c]));
+    }
+
+    return prevalentPatterns;
+}
+
+
+void JoinlessMiner::fillPrevalence(
+    const std::vector<Colocation>& candidates,
+    std::vector<PatternMetrics>& metrics,
+    double minPrev
+) {
+    if (candidates.empty()) return;
+    const size_t patternSize = candidates.front().size();
+
+    // Flatten ranks and PRs of the level, then evaluate all WPIs in one pass
+    std::vector<uint32_t> ranks;
+    std::vector<double> prs;
+    ranks.reserve(candidates.size() * patternSize);
+    prs.reserve(candidates.size() * patternSize);
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        for (size_t i = 0; i < patternSize; ++i) {
+            ranks.push_back(static_cast<uint32_t>(ranking.rank(candidates[c][i])));
+            prs.push_back(metrics[c].participationRatios[i]);
+        }
+    }
+    std::vector<double> wpi;
+    rareWeights.levelWPI(ranks, prs, patternSize, wpi);
+
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        const auto& candidatePRs = metrics[c].participationRatios;
+        metrics[c].participationIndex = *std::min_element(candidatePRs.begin(), candidatePRs.end());
+        metrics[c].weightedParticipationIndex = wpi[c];
+        metrics[c].prevalent = metrics[c].exact && wpi[c] >= minPrev;
+    }
+}
+
+
+std::map<Colocation, PairParticipation> JoinlessMiner::countPairParticipation(
+    const NRTree& orderedNRTree,
+    const std::map<FeatureType, int>& featureCount
+) {
+    std::map<Colocation, PairParticipation> result;
+    const NRNode* root = orderedNRTree.getRoot();
+    if (!root) return result;
+
+    // Level 1: center feature -> Level 2: star center -> Level 3: neighbor feature -> Level 4: neighbors
+    for (const auto* featureNode : root->children) {
+        // Bitmaps of this center feature, per neighbor feature (avoids a map lookup per star)
+        std::unordered_map<FeatureType, PairParticipation*> pairBitmaps;
+
+        for (const auto* instanceNode : featureNode->children) {
+            const SpatialInstance* center = instanceNode->data;
+
+            for (const auto* neighborFeatureNode : instanceNode->children) {
+                if (neighborFeatureNode->children.empty()) continue;
+                const auto& neighbors = neighborFeatureNode->children[0]->instanceVector;
+                if (neighbors.empty()) continue;
+
+                auto& pair = pairBitmaps[neighborFeatureNode->featureType];
+                if (!pair) {
+                    pair = &result[{ featureNode->featureType, neighborFeatureNode->featureType }];
+                    pair->bitmaps.emplace_back(featureCount.at(featureNode->featureType));
+                    pair->bitmaps.emplace_back(featureCount.at(neighborFeatureNode->featureType));
+                }
+
+                pair->bitmaps[0].set(center->ordinal);
+                for (const auto* neighbor : neighbors) {
+                    pair->bitmaps[1].set(neighbor->ordinal);
+                }
+                pair->rowCount += neighbors.size();
             }
+        }
+    }
+    return result;
+}
 
-            double wpr = pr * weight;
 
-            if (isFirstFeature) {
-                wpi = wpr;
-                isFirstFeature = false;
+std::map<Colocation, PackedTable> JoinlessMiner::genPairTableInstance(
+    const std::vector<Colocation>& pairs,
+    const NRTree& orderedNRTree,
+    size_t budgetBytes,
+    std::unique_ptr<SpilledTables>& spilled,
+    size_t& heldBytes,
+    LevelArena& arena,
+    std::map<Colocation, ExtensionTable>& extensions
+) {
+    std::map<Colocation, PackedTable> result;
+    extensions.clear();
+    heldBytes = 0;
+    const NRNode* root = orderedNRTree.getRoot();
+    if (!root || pairs.empty()) return result;
+
+    // Partner features of every center feature, in feature order
+    std::unordered_map<FeatureType, std::vector<FeatureType>> partners;
+    for (const auto& pair : pairs) {
+        partners[pair[0]].push_back(pair[1]);
+    }
+    for (auto& entry : partners) {
+        std::sort(entry.second.begin(), entry.second.end(), [this](const FeatureType& a, const FeatureType& b) {
+            return ranking.rank(a) < ranking.rank(b);
+        });
+    }
+
+    // Once the level is over budget, later pairs carry no extension sets: most of their
+    // tables go to disk, and the sets of spilled tables would stay in the arena
+    bool overBudget = false;
+    for (const auto* featureNode : root->children) {
+        const auto partnersIt = partners.find(featureNode->featureType);
+        if (partnersIt == partners.end()) continue;
+        const std::vector<FeatureType>& centerPartners = partnersIt->second;
+
+        // One pair at a time, so every finished table is accounted before the next is built
+        for (size_t p = 0; p < centerPartners.size(); ++p) {
+            const Colocation pair{ featureNode->featureType, centerPartners[p] };
+            const size_t partnerRank = ranking.rank(centerPartners[p]);
+
+            // Star child of the partner feature per center instance (stars are in feature order)
+            std::vector<const NRNode*> partnerNodes(featureNode->children.size(), nullptr);
+            size_t rowCount = 0;
+            for (size_t i = 0; i < featureNode->children.size(); ++i) {
+                const auto& children = featureNode->children[i]->children;
+                const auto it = std::lower_bound(children.begin(), children.end(), partnerRank,
+                    [this](const NRNode* child, size_t rank) { return ranking.rank(child->featureType) < rank; });
+                if (it == children.end() || (*it)->featureType != centerPartners[p] || (*it)->children.empty()) continue;
+                partnerNodes[i] = *it;
+                rowCount += (*it)->children[0]->instanceVector.size();
             }
-            else {
-                if (wpr < wpi) {
-                    wpi = wpr;
+            if (rowCount == 0) continue;  // Pairs without any row carry no extension table
+
+            // Extension features of pair {center, f}: the partners ranked after f
+            ExtensionTable ext(arena.local());
+            std::vector<size_t> extensionRanks;
+            const bool carrySets = !overBudget;
+            if (carrySets) {
+                ext.features.assign(centerPartners.begin() + p + 1, centerPartners.end());
+                for (const auto& feature : ext.features) extensionRanks.push_back(ranking.rank(feature));
+                ext.sets.reserve(rowCount);
+            }
+
+            // Rows {center, neighbor} are built in a fixed-width table, then handed over unchanged
+            TableInstance<2> rows;
+            rows.reserve(rowCount);
+            for (size_t i = 0; i < featureNode->children.size(); ++i) {
+                if (!partnerNodes[i]) continue;
+                const NRNode* instanceNode = featureNode->children[i];
+                const auto centerSets = starNeighborSets(instanceNode, ext.features, extensionRanks);
+
+                for (const auto* neighbor : partnerNodes[i]->children[0]->instanceVector) {
+                    rows.pushExtended(&instanceNode->data->ordinal, neighbor->ordinal);
+                    if (!carrySets) continue;
+
+                    // S({c, n}, g) = Neigh(c, g) ∩ Neigh(n, g)
+                    const auto neighborSets = starNeighborSets(orderedNRTree.findStar(neighbor), ext.features, extensionRanks);
+                    std::pmr::vector<ExtensionTable::InstanceSet> rowSets(ext.features.size(), ext.sets.get_allocator());
+                    for (size_t j = 0; j < rowSets.size(); ++j) {
+                        if (centerSets[j] && neighborSets[j]) {
+                            intersectByOrdinal(*centerSets[j], *neighborSets[j], rowSets[j]);
+                        }
+                    }
+                    ext.sets.push_back(std::move(rowSets));
                 }
             }
-        }
 
-        // Check threshold
-        if (wpi >= minPrev) {
-            prevalentPatterns.push_back(candidate);
+            // Keep the table while the level fits into the budget, otherwise write it to disk
+            // (its extension sets are dropped and recomputed when it is read back as a prefix)
+            PackedTable packed(std::move(rows));
+            const size_t tableBytes = estimateTableBytes(packed, carrySets ? &ext : nullptr);
+            if (budgetBytes != 0 && heldBytes + tableBytes > budgetBytes) {
+                if (!spilled) spilled.reset(new SpilledTables());
+                if (spilled->spill(pair, packed)) {
+                    overBudget = true;
+                    continue;
+                }
+            }
+            heldBytes += tableBytes;
+            if (carrySets) extensions.emplace(pair, std::move(ext));
+            result.emplace(pair, std::move(packed));
         }
     }
+    return result;
+}
 
-    return prevalentPatterns;
+
+std::vector<const std::vector<const SpatialInstance*>*> JoinlessMiner::starNeighborSets(
+    const NRNode* star,
+    const std::vector<FeatureType>& features,
+    const std::vector<size_t>& ranks
+) const {
+    std::vector<const std::vector<const SpatialInstance*>*> result(features.size(), nullptr);
+    if (!star) return result;
+
+    // Star children are in feature order too, so one forward walk matches both lists
+    const auto& children = star->children;
+    size_t c = 0;
+    for (size_t j = 0; j < features.size(); ++j) {
+        while (c < children.size() && ranking.rank(children[c]->featureType) < ranks[j]) ++c;
+        if (c == children.size()) break;
+        if (children[c]->featureType == features[j] && !children[c]->children.empty()) {
+            result[j] = &children[c]->children[0]->instanceVector;
+        }
+    }
+    return result;
 }
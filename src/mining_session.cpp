@@ -0,0 +1,112 @@
+/**
+ * @file mining_session.cpp
+ * @brief Implementation of the resident mining session
+ */
+
+#include "mining_session.h"
+#include "data_loader.h"
+#include "spatial_index.h"
+#include "neighborhood_mgr.h"
+#include "trace.h"
+#include <atomic>
+#include <unordered_map>
+
+namespace {
+
+// mine() calls running in the process, and the number of calls that started while
+// another one was running: a call overlapped another if the count moved during it
+std::atomic<unsigned> activeMineCalls(0);
+std::atomic<uint64_t> overlappingMineCalls(0);
+
+class ActiveMineCall {
+public:
+    ActiveMineCall() : overlapsAtStart(overlappingMineCalls.load()) {
+        if (activeMineCalls.fetch_add(1) != 0) overlappingMineCalls.fetch_add(1);
+    }
+    ~ActiveMineCall() { activeMineCalls.fetch_sub(1); }
+
+    ActiveMineCall(const ActiveMineCall&) = delete;
+    ActiveMineCall& operator=(const ActiveMineCall&) = delete;
+
+    /** @brief Whether no other call ran at any time since construction */
+    bool exclusive() const { return overlappingMineCalls.load() == overlapsAtStart; }
+
+private:
+    uint64_t overlapsAtStart;
+};
+
+// Keeps only what one call measures by itself (name and wall time)
+StageStats wallTimeOnly(const StageStats& stats) {
+    StageStats kept;
+    kept.name = stats.name;
+    kept.wallSeconds = stats.wallSeconds;
+    return kept;
+}
+
+}
+
+MiningSession::MiningSession(const std::string& datasetPath, const IndexOptions& options, const StageCallback& onStage)
+    : options(options) {
+    if (onStage) onStage("load");
+    const StageTimer loadTimer;
+    index(DataLoader::load_csv(datasetPath), loadTimer, onStage);
+}
+
+MiningSession::MiningSession(std::vector<SpatialInstance> dataset, const IndexOptions& options, const StageCallback& onStage)
+    : options(options) {
+    if (onStage) onStage("load");
+    const StageTimer loadTimer;
+    // Ordinals index the participation bitmaps and the NR-tree: number the instances of
+    // every feature densely in input order, as DataLoader::load_csv does
+    std::unordered_map<FeatureType, uint32_t> nextOrdinal;
+    for (auto& instance : dataset) instance.ordinal = nextOrdinal[instance.type]++;
+    index(dataset, loadTimer, onStage);
+}
+
+void MiningSession::index(const std::vector<SpatialInstance>& loaded, const StageTimer& loadTimer, const StageCallback& onStage) {
+    TRACE_SCOPE("MiningSession::index");
+    const auto beginStage = [&onStage](const std::string& name) {
+        if (onStage) onStage(name);
+        return StageTimer();
+    };
+
+    instances = loaded.size();
+    featureRanking = FeatureRanking(loaded);
+    stages.push_back(loadTimer.stop("load"));
+
+    const StageTimer joinTimer = beginStage("grid_join");
+    const SpatialIndex spatialIndex(options.neighborDistance, options.cellSplitThreshold, options.coordinateSystem);
+    neighborPairs = spatialIndex.findNeighborPair(loaded);
+    stages.push_back(joinTimer.stop("grid_join"));
+
+    // The neighborhoods are only needed to build the tree; the tree keeps pointers into
+    // neighborPairs, which stay with the session
+    const StageTimer neighborhoodTimer = beginStage("neighborhood_build");
+    NeighborhoodMgr neighborMgr;
+    neighborMgr.buildFromPairs(neighborPairs, featureRanking);
+    stages.push_back(neighborhoodTimer.stop("neighborhood_build"));
+
+    const StageTimer treeTimer = beginStage("nrtree_build");
+    orderedNRTree.build(neighborMgr, featureRanking);
+    stages.push_back(treeTimer.stop("nrtree_build"));
+}
+
+MiningResult MiningSession::mine(double minPrev, const MiningOptions& options, ProgressCallback progressCb) const {
+    TRACE_SCOPE("MiningSession::mine");
+    const ActiveMineCall call;
+    MiningResult result;
+    const StageTimer miningTimer;
+    JoinlessMiner miner;
+    result.patterns = miner.mineColocations(minPrev, orderedNRTree, featureRanking, options, progressCb);
+    result.resources = miningTimer.stop("mining");
+    result.levels = miner.levelStats();
+
+    // CPU time, RSS, faults, hardware events and allocations are read process-wide: with
+    // another call running they include its work, so only the wall times are kept
+    result.exclusive = call.exclusive();
+    if (!result.exclusive) {
+        result.resources = wallTimeOnly(result.resources);
+        for (auto& level : result.levels) level.resources = wallTimeOnly(level.resources);
+    }
+    return result;
+}
@@ -5,6 +5,7 @@
 
 #include "neighborhood_mgr.h"
 #include "utils.h"
+#include "trace.h"
 #include <algorithm>
 
 
@@ -12,35 +13,31 @@
  * @brief Check if neighbor should be included in center's ordered neighborhood
  * @param centerType Feature type of the center instance
  * @param neighborType Feature type of the neighbor instance
- * @param counts Map of instance counts for each feature type
+ * @param ranking Feature order of the dataset
  * @return bool True if neighbor should be in center's ordered neighborhood
  * 
  * Ordering is based on instance count (ascending). For equal counts, uses lexicographic order.
  */
 bool NeighborhoodMgr::isOrdered(const FeatureType& centerType,
     const FeatureType& neighborType,
-    const std::map<FeatureType, int>& counts){
+    const FeatureRanking& ranking){
 
-    int numCenter = counts.at(centerType);
-    int numNeighbor = counts.at(neighborType);
-
-    if (numCenter < numNeighbor) return true;
-    if (numCenter == numNeighbor) return centerType <= neighborType;
-    return false;
+    return ranking.rank(centerType) <= ranking.rank(neighborType);
 }
 
 
 /**
  * @brief Build ordered neighborhoods from neighbor pairs
  * @param pairs Vector of neighbor pairs found by spatial indexing
- * @param featureCounts Map of instance counts for each feature type
+ * @param ranking Feature order of the dataset
  * 
  * Constructs bidirectional ordered neighborhoods. For each pair (A, B):
  * - If A's feature count <= B's feature count, B is added to A's neighborhood
  * - If B's feature count <= A's feature count, A is added to B's neighborhood
  */
 void NeighborhoodMgr::buildFromPairs(const std::vector<std::pair<SpatialInstance, SpatialInstance>>& pairs,
-    const std::map<FeatureType, int>& featureCounts) {
+    const FeatureRanking& ranking) {
+    TRACE_SCOPE("buildFromPairs");
     
     orderedNeighborMap.clear();
     
@@ -49,7 +46,7 @@ void NeighborhoodMgr::buildFromPairs(const std::vector<std::pair<SpatialInstance
         const SpatialInstance& neighbor = pair.second;
 
         // Check if neighbor belongs to center's ordered neighborhood
-        if (isOrdered(center.type, neighbor.type, featureCounts)) {
+        if (isOrdered(center.type, neighbor.type, ranking)) {
             auto& neighborhoodList = orderedNeighborMap[center.type];
             auto existingNeighborhood = std::find_if(neighborhoodList.begin(), neighborhoodList.end(), [&](const OrderedNeigh& set) {
                 return set.center->id == center.id;
@@ -67,7 +64,7 @@ void NeighborhoodMgr::buildFromPairs(const std::vector<std::pair<SpatialInstance
         }
         
         // Check if center belongs to neighbor's ordered neighborhood
-        if (isOrdered(neighbor.type, center.type, featureCounts)) {
+        if (isOrdered(neighbor.type, center.type, ranking)) {
             auto& neighborhoodList = orderedNeighborMap[neighbor.type];
             auto existingNeighborhood = std::find_if(neighborhoodList.begin(), neighborhoodList.end(), [&](const OrderedNeigh& set) {
                 return set.center->id == neighbor.id;
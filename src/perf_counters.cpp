@@ -0,0 +1,157 @@
+/**
+ * @file perf_counters.cpp
+ * @brief Implementation of the hardware performance counters
+ */
+
+#include "perf_counters.h"
+#include <iostream>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+#if defined(__linux__)
+
+// perf_event_attr type and config of every HardwareEvent, in enum order
+struct EventCode {
+    uint32_t type;
+    uint64_t config;
+};
+
+const std::array<EventCode, HARDWARE_EVENT_COUNT> EVENT_CODES = { {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+} };
+
+// Counter of one event on the calling thread (user space only); -1 if unavailable
+int openEvent(const EventCode& code) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = code.type;
+    attr.config = code.config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+// Count of an event, extrapolated if the kernel multiplexed it with other events
+bool readEvent(int fd, uint64_t& value) {
+    uint64_t data[3] = { 0, 0, 0 };  // value, time enabled, time running
+    if (::read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) return false;
+    value = (data[2] != 0 && data[2] < data[1])
+        ? static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] / data[2])
+        : data[0];
+    return true;
+}
+
+#endif
+
+}
+
+
+HardwareCounterValues HardwareCounterValues::since(const HardwareCounterValues& earlier) const {
+    HardwareCounterValues delta;
+    for (size_t e = 0; e < HARDWARE_EVENT_COUNT; ++e) {
+        delta.available[e] = available[e] && earlier.available[e];
+        if (delta.available[e]) delta.values[e] = values[e] - earlier.values[e];
+    }
+    return delta;
+}
+
+const char* hardwareEventName(HardwareEvent event) {
+    switch (event) {
+    case HardwareEvent::CYCLES: return "cycles";
+    case HardwareEvent::INSTRUCTIONS: return "instructions";
+    case HardwareEvent::LLC_MISSES: return "llc_misses";
+    case HardwareEvent::BRANCH_MISSES: return "branch_misses";
+    case HardwareEvent::DTLB_MISSES: return "dtlb_misses";
+    }
+    return "unknown";
+}
+
+
+HardwareCounters& HardwareCounters::instance() {
+    static HardwareCounters counters;
+    return counters;
+}
+
+HardwareCounters::~HardwareCounters() {
+#if defined(__linux__)
+    for (const auto& fds : threadFds) {
+        for (const int fd : fds) {
+            if (fd >= 0) ::close(fd);
+        }
+    }
+#endif
+}
+
+void HardwareCounters::open() {
+    if (opened || !threadFds.empty()) return;
+
+    openForThisThread();
+#ifdef _OPENMP
+    // Worker threads of the OpenMP pool; the calling thread is the team's master
+    #pragma omp parallel
+    {
+        if (omp_get_thread_num() != 0) openForThisThread();
+    }
+#endif
+
+    // Same rule as read(): an event counts only if every thread could open it
+    std::array<bool, HARDWARE_EVENT_COUNT> counted;
+    counted.fill(true);
+    for (const auto& fds : threadFds) {
+        for (size_t e = 0; e < HARDWARE_EVENT_COUNT; ++e) counted[e] = counted[e] && fds[e] >= 0;
+    }
+    std::string missing;
+    for (size_t e = 0; e < HARDWARE_EVENT_COUNT; ++e) {
+        if (counted[e]) opened = true;
+        else missing += std::string(missing.empty() ? "" : ", ") + hardwareEventName(static_cast<HardwareEvent>(e));
+    }
+    if (!missing.empty()) {
+        std::cerr << "Warning: hardware counters unavailable (" << missing
+            << "); check perf_event_paranoid or PMU support.\n";
+    }
+}
+
+void HardwareCounters::openForThisThread() {
+    std::array<int, HARDWARE_EVENT_COUNT> fds;
+    fds.fill(-1);
+#if defined(__linux__)
+    for (size_t e = 0; e < HARDWARE_EVENT_COUNT; ++e) fds[e] = openEvent(EVENT_CODES[e]);
+#endif
+    std::lock_guard<std::mutex> lock(fdMutex);
+    threadFds.push_back(fds);
+}
+
+HardwareCounterValues HardwareCounters::read() const {
+    HardwareCounterValues total;
+    if (!opened) return total;
+#if defined(__linux__)
+    // An event is reported only if it is counted on every thread that opened counters
+    total.available.fill(true);
+    for (const auto& fds : threadFds) {
+        for (size_t e = 0; e < HARDWARE_EVENT_COUNT; ++e) {
+            uint64_t value = 0;
+            if (fds[e] < 0 || !readEvent(fds[e], value)) {
+                total.available[e] = false;
+                continue;
+            }
+            total.values[e] += value;
+        }
+    }
+#endif
+    return total;
+}
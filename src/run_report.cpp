@@ -0,0 +1,153 @@
+/**
+ * @file run_report.cpp
+ * @brief Implementation of the JSON run report
+ */
+
+#include "run_report.h"
+#include "json_util.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+std::string jsonNumber(double value) {
+    std::ostringstream out;
+    out << std::setprecision(10) << value;
+    return out.str();
+}
+
+// Hardware events of a stage; with rows > 0 also per table row
+void writeCounters(std::ostream& out, const HardwareCounterValues& counters, size_t rows) {
+    if (!counters.any()) return;
+    out << ", \"hw\": { \"ipc\": " << jsonNumber(counters.ipc());
+    for (size_t e = 0; e < HARDWARE_EVENT_COUNT; ++e) {
+        const HardwareEvent event = static_cast<HardwareEvent>(e);
+        if (!counters.has(event)) continue;
+        out << ", \"" << hardwareEventName(event) << "\": " << counters.value(event);
+        if (rows > 0) {
+            out << ", \"" << hardwareEventName(event) << "_per_row\": "
+                << jsonNumber(static_cast<double>(counters.value(event)) / rows);
+        }
+    }
+    out << " }";
+}
+
+// Heap allocation traffic of a stage; with rows > 0 also allocations per table row
+void writeAllocations(std::ostream& out, const AllocationStats& allocations, size_t rows) {
+    if (!allocations.available) return;
+    out << ", \"alloc\": { \"count\": " << allocations.allocations
+        << ", \"frees\": " << allocations.deallocations
+        << ", \"mb\": " << jsonNumber(allocations.bytes / (1024.0 * 1024.0))
+        << ", \"peak_live_mb\": " << jsonNumber(allocations.peakLiveBytes / (1024.0 * 1024.0));
+    if (allocations.allocations > 0) {
+        out << ", \"avg_bytes\": " << jsonNumber(static_cast<double>(allocations.bytes) / allocations.allocations);
+    }
+    if (rows > 0) {
+        out << ", \"count_per_row\": " << jsonNumber(static_cast<double>(allocations.allocations) / rows);
+    }
+    out << " }";
+}
+
+void writeResources(std::ostream& out, const StageStats& stats) {
+    out << "\"wall_s\": " << jsonNumber(stats.wallSeconds)
+        << ", \"cpu_s\": " << jsonNumber(stats.cpuSeconds)
+        << ", \"process_peak_rss_mb\": " << jsonNumber(stats.processPeakRSSMB)
+        << ", \"peak_rss_growth_mb\": " << jsonNumber(stats.peakRSSGrowthMB)
+        << ", \"minor_faults\": " << stats.minorFaults
+        << ", \"major_faults\": " << stats.majorFaults
+        << ", \"voluntary_ctx_switches\": " << stats.voluntaryContextSwitches
+        << ", \"involuntary_ctx_switches\": " << stats.involuntaryContextSwitches;
+}
+
+}
+
+
+StageTimer::StageTimer()
+    : wallStart(std::chrono::high_resolution_clock::now()),
+      usageStart(sampleResourceUsage()),
+      countersStart(HardwareCounters::instance().read()),
+      allocationsStart(AllocationTracker::read()) {}
+
+StageStats StageTimer::stop(const std::string& name) const {
+    StageStats stats;
+    stats.name = name;
+    stats.wallSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - wallStart).count();
+    const ResourceUsage usage = sampleResourceUsage();
+    stats.cpuSeconds = usage.cpuSeconds() - usageStart.cpuSeconds();
+    // VmHWM is process-wide and cannot be reset per stage (stages nest: levels run inside
+    // mining), so a stage reports the high-water mark and how far it raised it
+    stats.processPeakRSSMB = usage.peakRSSMB;
+    stats.peakRSSGrowthMB = std::max(0.0, usage.peakRSSMB - usageStart.peakRSSMB);
+    stats.minorFaults = usage.minorFaults - usageStart.minorFaults;
+    stats.majorFaults = usage.majorFaults - usageStart.majorFaults;
+    stats.voluntaryContextSwitches = usage.voluntaryContextSwitches - usageStart.voluntaryContextSwitches;
+    stats.involuntaryContextSwitches = usage.involuntaryContextSwitches - usageStart.involuntaryContextSwitches;
+    stats.counters = HardwareCounters::instance().read().since(countersStart);
+    stats.allocations = AllocationTracker::read().since(allocationsStart);
+    stats.allocations.peakLiveBytes = allocationPeak.peak();
+    return stats;
+}
+
+
+void RunReport::setText(const std::string& key, const std::string& value) {
+    fields.push_back({ key, jsonString(value) });
+}
+
+void RunReport::setNumber(const std::string& key, double value) {
+    fields.push_back({ key, jsonNumber(value) });
+}
+
+bool RunReport::writeJson(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+
+    out << "{\n";
+    for (const auto& field : fields) {
+        out << "  " << jsonString(field.first) << ": " << field.second << ",\n";
+    }
+
+    out << "  \"stages\": [";
+    for (size_t i = 0; i < stageList.size(); ++i) {
+        out << (i ? ",\n" : "\n") << "    { \"name\": " << jsonString(stageList[i].name) << ", ";
+        writeResources(out, stageList[i]);
+        writeCounters(out, stageList[i].counters, 0);
+        writeAllocations(out, stageList[i].allocations, 0);
+        out << " }";
+    }
+    out << (stageList.empty() ? "],\n" : "\n  ],\n");
+
+    out << "  \"levels\": [";
+    for (size_t i = 0; i < levelList.size(); ++i) {
+        const LevelStats& level = levelList[i];
+        out << (i ? ",\n" : "\n")
+            << "    { \"k\": " << level.patternSize
+            << ", \"candidates\": " << level.candidates
+            << ", \"filtered\": " << level.filtered
+            << ", \"table_rows\": " << level.tableRows
+            << ", \"prevalent\": " << level.prevalent
+            << ", \"bytes_held\": " << level.bytesHeld
+            << ", \"peak_bytes_held\": " << level.peakBytesHeld
+            << ", \"arena_bytes\": " << level.arenaBytes
+            << ", \"spilled_tables\": " << level.spilledTables
+            << ", \"spilled_bytes\": " << level.spilledBytes << ", ";
+        writeResources(out, level.resources);
+        writeCounters(out, level.resources.counters, level.tableRows);
+        writeAllocations(out, level.resources.allocations, level.tableRows);
+        out << " }";
+    }
+    out << (levelList.empty() ? "],\n" : "\n  ],\n");
+
+    out << "  \"memory_timeline\": [";
+    for (size_t i = 0; i < memoryTimeline.size(); ++i) {
+        const MemorySample& sample = memoryTimeline[i];
+        out << (i ? ",\n" : "\n")
+            << "    { \"t_s\": " << jsonNumber(sample.seconds)
+            << ", \"rss_mb\": " << jsonNumber(sample.rssMB)
+            << ", \"stage\": " << jsonString(sample.stage) << " }";
+    }
+    out << (memoryTimeline.empty() ? "]\n" : "\n  ]\n");
+    out << "}\n";
+    return static_cast<bool>(out);
+}
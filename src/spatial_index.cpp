@@ -4,17 +4,208 @@
  */
 
 #include "spatial_index.h"
+#include "trace.h"
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <array>
+#include <unordered_map>
+
+
+namespace {
+
+/**
+ * @brief Node of the quadtree that refines one grid cell
+ * 
+ * A node covers the points cellPoints[begin, end) and stores their tight bounding box.
+ * Children are stored contiguously in the node pool starting at firstChild.
+ */
+struct QuadNode {
+    double minX, minY, maxX, maxY;  ///< Tight bounding box of the node's points
+    size_t begin, end;              ///< Range of the node's points in the cell point array
+    size_t firstChild;              ///< Pool index of the first child (valid if childCount > 0)
+    size_t childCount;              ///< Number of non-empty quadrants (0 for a leaf)
+
+    size_t size() const { return end - begin; }
+    bool isLeaf() const { return childCount == 0; }
+};
+
+/**
+ * @brief Unit of join work: a pair of quadtree nodes
+ * 
+ * selfJoin is set when both sides are the same node, in which case each unordered
+ * point pair is visited once.
+ */
+struct JoinTask {
+    size_t nodeA;
+    size_t nodeB;
+    bool selfJoin;
+};
+
+/** @brief How a node pair has to be processed */
+enum class JoinAction {
+    SKIP,   ///< Bounding boxes are farther apart than the threshold
+    WHOLE,  ///< Every point pair is within the threshold
+    SPLIT,  ///< Recurse into the children of the larger node
+    SCAN    ///< Leaf against leaf: check every point pair
+};
+
+/** @brief Smallest possible distance between points of two nodes */
+double minBoxDist(const QuadNode& a, const QuadNode& b) {
+    const double gapX = std::max(0.0, std::max(a.minX - b.maxX, b.minX - a.maxX));
+    const double gapY = std::max(0.0, std::max(a.minY - b.maxY, b.minY - a.maxY));
+    return std::sqrt(gapX * gapX + gapY * gapY);
+}
+
+/** @brief Largest possible distance between points of two nodes */
+double maxBoxDist(const QuadNode& a, const QuadNode& b) {
+    const double spanX = std::max(a.maxX - b.minX, b.maxX - a.minX);
+    const double spanY = std::max(a.maxY - b.minY, b.maxY - a.minY);
+    return std::sqrt(spanX * spanX + spanY * spanY);
+}
+
+/**
+ * @brief Quadtree forest over the occupied grid cells
+ * 
+ * Every occupied cell gets a root node; cells above the split threshold are subdivided
+ * recursively at the center of their bounding box until leaves are small enough.
+ */
+class CellForest {
+public:
+    std::vector<QuadNode> nodes;     ///< Node pool shared by all cells
+    std::vector<size_t> cellPoints;  ///< Instance indices grouped by cell, permuted by quadtree builds
+
+    CellForest(const std::vector<double>& gridX, const std::vector<double>& gridY, size_t splitThreshold)
+        : gridX(gridX), gridY(gridY), splitThreshold(splitThreshold) {}
+
+    /** @brief Build the tree for cellPoints[begin, end) and return its root index */
+    size_t buildCell(size_t begin, size_t end) {
+        const size_t root = nodes.size();
+        nodes.push_back(makeNode(begin, end));
+        subdivide(root, 0);
+        return root;
+    }
+
+    /**
+     * @brief Decide how to process a node pair and produce its sub-pairs if it has to be split
+     * 
+     * Box distances are evaluated with the same formula as the point distance, so the
+     * SKIP/WHOLE shortcuts never disagree with a per-pair check (rounding is monotone).
+     * WHOLE is only valid when grid distances are the real distances (planar mode).
+     */
+    JoinAction classify(const JoinTask& task, double threshold, bool allowWhole,
+                        std::array<JoinTask, 10>& subtasks, size_t& subtaskCount) const {
+        const QuadNode& a = nodes[task.nodeA];
+        const QuadNode& b = nodes[task.nodeB];
+        subtaskCount = 0;
+
+        if (!task.selfJoin && minBoxDist(a, b) > threshold) return JoinAction::SKIP;
+        if (allowWhole && maxBoxDist(a, b) <= threshold) return JoinAction::WHOLE;
+        if (a.isLeaf() && b.isLeaf()) return JoinAction::SCAN;
+
+        if (task.selfJoin) {
+            for (size_t i = 0; i < a.childCount; ++i) {
+                for (size_t j = i; j < a.childCount; ++j) {
+                    subtasks[subtaskCount++] = { a.firstChild + i, a.firstChild + j, i == j };
+                }
+            }
+        }
+        else if (!a.isLeaf() && (b.isLeaf() || a.size() >= b.size())) {
+            for (size_t i = 0; i < a.childCount; ++i) {
+                subtasks[subtaskCount++] = { a.firstChild + i, task.nodeB, false };
+            }
+        }
+        else {
+            for (size_t j = 0; j < b.childCount; ++j) {
+                subtasks[subtaskCount++] = { task.nodeA, b.firstChild + j, false };
+            }
+        }
+        return JoinAction::SPLIT;
+    }
+
+private:
+    const std::vector<double>& gridX;
+    const std::vector<double>& gridY;
+    size_t splitThreshold;
+
+    QuadNode makeNode(size_t begin, size_t end) const {
+        QuadNode node{ 0.0, 0.0, 0.0, 0.0, begin, end, 0, 0 };
+        node.minX = node.maxX = gridX[cellPoints[begin]];
+        node.minY = node.maxY = gridY[cellPoints[begin]];
+        for (size_t p = begin + 1; p < end; ++p) {
+            node.minX = std::min(node.minX, gridX[cellPoints[p]]);
+            node.maxX = std::max(node.maxX, gridX[cellPoints[p]]);
+            node.minY = std::min(node.minY, gridY[cellPoints[p]]);
+            node.maxY = std::max(node.maxY, gridY[cellPoints[p]]);
+        }
+        return node;
+    }
+
+    void subdivide(size_t nodeIdx, int depth) {
+        const QuadNode node = nodes[nodeIdx];
+        if (node.size() <= splitThreshold || depth >= Constants::MAX_QUADTREE_DEPTH) return;
+        if (node.minX == node.maxX && node.minY == node.maxY) return;  // All points coincide
+
+        const double midX = 0.5 * (node.minX + node.maxX);
+        const double midY = 0.5 * (node.minY + node.maxY);
+        auto first = cellPoints.begin() + node.begin;
+        auto last = cellPoints.begin() + node.end;
+
+        // Partition into quadrants: [x < midX, y < midY], [x < midX, y >= midY], ...
+        auto splitX = std::partition(first, last, [&](size_t p) { return gridX[p] < midX; });
+        auto splitLow = std::partition(first, splitX, [&](size_t p) { return gridY[p] < midY; });
+        auto splitHigh = std::partition(splitX, last, [&](size_t p) { return gridY[p] < midY; });
+        const std::array<decltype(first), 5> bounds = { first, splitLow, splitX, splitHigh, last };
+
+        const size_t firstChild = nodes.size();
+        for (size_t q = 0; q < 4; ++q) {
+            if (bounds[q] == bounds[q + 1]) continue;
+            nodes.push_back(makeNode(bounds[q] - cellPoints.begin(), bounds[q + 1] - cellPoints.begin()));
+        }
+        nodes[nodeIdx].firstChild = firstChild;
+        nodes[nodeIdx].childCount = nodes.size() - firstChild;
+
+        for (size_t c = firstChild; c < firstChild + nodes[nodeIdx].childCount; ++c) {
+            subdivide(c, depth + 1);
+        }
+    }
+};
+
+/**
+ * @brief Great-circle neighbor test of one point against a contiguous run of points
+ * 
+ * Compares squared chord lengths between unit vectors, which is equivalent to comparing
+ * great-circle distances but needs no trigonometry per pair. The loop body is branch-free
+ * so it is vectorized (OpenMP SIMD).
+ * 
+ * @param within Output flags, within[j - begin] is set when point j is a neighbor of p
+ */
+void chordKernel(const double* ux, const double* uy, const double* uz,
+                 size_t p, size_t begin, size_t end, double maxChordSq, unsigned char* within) {
+    const double px = ux[p];
+    const double py = uy[p];
+    const double pz = uz[p];
+    #pragma omp simd
+    for (size_t j = begin; j < end; ++j) {
+        const double dx = ux[j] - px;
+        const double dy = uy[j] - py;
+        const double dz = uz[j] - pz;
+        within[j - begin] = (dx * dx + dy * dy + dz * dz <= maxChordSq);
+    }
+}
+
+} // namespace
 
 
 /**
  * @brief Constructor to initialize SpatialIndex with a distance threshold
  * @param distThresh Maximum distance for two instances to be considered neighbors
+ * @param cellSplitThresh Occupancy above which a grid cell is refined into a quadtree
  */
-SpatialIndex::SpatialIndex(double distThresh)
-    : distanceThreshold(distThresh)
+SpatialIndex::SpatialIndex(double distThresh, size_t cellSplitThresh, CoordinateSystem coordSystem)
+    : distanceThreshold(distThresh),
+      cellSplitThreshold(std::max<size_t>(cellSplitThresh, 1)),
+      coordinateSystem(coordSystem)
 {
 }
 
@@ -32,83 +223,322 @@ double SpatialIndex::euclideanDist(const SpatialInstance& a, const SpatialInstan
 }
 
 
+/**
+ * @brief Project instances onto the plane used for grid bucketing
+ * @param instances Vector of all spatial instances
+ * @param gridX Output projected x coordinate per instance
+ * @param gridY Output projected y coordinate per instance
+ * 
+ * Geodesic mode maps (lon, lat) to (R * dLon * cos(latBound), R * lat) with
+ * latBound = max|lat| + threshold / R. Every point of the great-circle path between two
+ * neighbors is within the threshold of one end, so the path stays below latBound, does
+ * not pass a pole, and has length >= sqrt((R * cos(latBound) * dLon)^2 + (R * dLat)^2)
+ * with dLon the longitude difference the shorter way round. Projected distances of
+ * neighbors that do not cross the seam are therefore at most the threshold, so a grid
+ * built with the threshold as cell size never separates them. If latBound reaches a pole
+ * (cos below MIN_PROJECTION_COS) the x axis is collapsed to 0 and only latitude is used.
+ */
+double SpatialIndex::projectToGrid(const std::vector<SpatialInstance>& instances,
+                                   std::vector<double>& gridX, std::vector<double>& gridY) const {
+    gridX.resize(instances.size());
+    gridY.resize(instances.size());
+
+    if (coordinateSystem == CoordinateSystem::PLANAR) {
+        for (size_t i = 0; i < instances.size(); ++i) {
+            gridX[i] = instances[i].x;
+            gridY[i] = instances[i].y;
+        }
+        return 0.0;
+    }
+
+    const double degToRad = std::acos(-1.0) / 180.0;
+    double maxAbsLat = 0.0;
+    std::vector<double> longitudes(instances.size());
+    for (size_t i = 0; i < instances.size(); ++i) {
+        maxAbsLat = std::max(maxAbsLat, std::abs(instances[i].y));
+        longitudes[i] = std::remainder(instances[i].x, 360.0);
+    }
+
+    // Reference: centre of the smallest longitude arc covering the data, i.e. opposite the
+    // largest gap between consecutive longitudes (including the gap across ±180°)
+    std::sort(longitudes.begin(), longitudes.end());
+    double largestGap = longitudes.front() + 360.0 - longitudes.back();
+    double arcStart = longitudes.front();
+    for (size_t i = 1; i < longitudes.size(); ++i) {
+        const double gap = longitudes[i] - longitudes[i - 1];
+        if (gap > largestGap) {
+            largestGap = gap;
+            arcStart = longitudes[i];
+        }
+    }
+    const double refLon = arcStart + 0.5 * (360.0 - largestGap);
+    const double latBound = maxAbsLat * degToRad + distanceThreshold / Constants::EARTH_RADIUS_METERS;
+    const double boundCos = (latBound < 0.5 * std::acos(-1.0)) ? std::cos(latBound) : 0.0;
+    const double scaleX = (boundCos < Constants::MIN_PROJECTION_COS) ? 0.0 : Constants::EARTH_RADIUS_METERS * boundCos;
+
+    // Δlon in [-180, 180], so the seam of the projection lies in the largest gap
+    for (size_t i = 0; i < instances.size(); ++i) {
+        const double deltaLon = std::remainder(instances[i].x - refLon, 360.0);
+        gridX[i] = scaleX * deltaLon * degToRad;
+        gridY[i] = Constants::EARTH_RADIUS_METERS * instances[i].y * degToRad;
+    }
+    return scaleX * 2.0 * std::acos(-1.0);
+}
+
+
 /**
  * @brief Find all neighbor pairs within the distance threshold
  * @param instances Vector of all spatial instances to search
  * @return std::vector<std::pair<SpatialInstance, SpatialInstance>> Vector of neighbor pairs
  * 
- * Uses grid-based spatial partitioning to optimize neighbor search from O(n²) to O(n).
- * Divides the spatial domain into grid cells and only checks instances in adjacent cells.
+ * Uses grid-based spatial partitioning with adaptive quadtree refinement of hot cells.
+ * The join is expressed as a list of node-pair tasks; tasks whose work exceeds the
+ * square of the split threshold are split further so a single hotspot is spread over
+ * many parallel tasks. Per-task results are concatenated in task order, keeping the
+ * output deterministic regardless of thread count.
  */
 std::vector<std::pair<SpatialInstance, SpatialInstance>> SpatialIndex::findNeighborPair(const std::vector<SpatialInstance>& instances) const {
+    TRACE_SCOPE("findNeighborPair");
     std::vector<std::pair<SpatialInstance, SpatialInstance>> neighborPairs;
 
-    // Safety check: empty instances
-    if (instances.empty()) {
+    // Safety check: empty instances or degenerate threshold
+    if (instances.empty() || !(distanceThreshold > 0.0)) {
         return neighborPairs;
     }
 
-    // Calculate spatial bounds
-    const double minX = std::min_element(instances.begin(), instances.end(),
-        [](const SpatialInstance& a, const SpatialInstance& b) { return a.x < b.x; })->x;
-    const double minY = std::min_element(instances.begin(), instances.end(),
-        [](const SpatialInstance& a, const SpatialInstance& b) { return a.y < b.y; })->y;
-    const double maxX = std::max_element(instances.begin(), instances.end(),
-        [](const SpatialInstance& a, const SpatialInstance& b) { return a.x < b.x; })->x;
-    const double maxY = std::max_element(instances.begin(), instances.end(),
-        [](const SpatialInstance& a, const SpatialInstance& b) { return a.y < b.y; })->y;
+    // Grid coordinates and search radius (geodesic: the threshold bounds projected distances
+    // of neighbors, the margin only absorbs rounding)
+    const bool geodesic = (coordinateSystem == CoordinateSystem::GEODESIC);
+    std::vector<double> gridX, gridY;
+    const double wrapWidth = projectToGrid(instances, gridX, gridY);
+    const double searchRadius = geodesic
+        ? distanceThreshold * (1.0 + Constants::GEODESIC_GRID_MARGIN)
+        : distanceThreshold;
 
+    // Calculate spatial bounds
+    const double minX = *std::min_element(gridX.begin(), gridX.end());
+    const double minY = *std::min_element(gridY.begin(), gridY.end());
+    const double maxX = *std::max_element(gridX.begin(), gridX.end());
+    const double maxY = *std::max_element(gridY.begin(), gridY.end());
 
     // Create grid cells based on distance threshold
-    const size_t gridCellsX = static_cast<size_t>(std::ceil((maxX - minX) / distanceThreshold));
-    const size_t gridCellsY = static_cast<size_t>(std::ceil((maxY - minY) / distanceThreshold));
+    // (+1 so that points lying exactly on the max boundary still get a cell)
+    const size_t gridCellsX = static_cast<size_t>(std::floor((maxX - minX) / searchRadius)) + 1;
+    const size_t gridCellsY = static_cast<size_t>(std::floor((maxY - minY) / searchRadius)) + 1;
     const size_t totalCells = gridCellsX * gridCellsY;
-    std::vector<std::vector<SpatialInstance>> gridCells(totalCells);
 
-    // Assign instances to grid cells
-    for (const auto& inst : instances) {
-        const size_t cellX = static_cast<size_t>((inst.x - minX) / distanceThreshold);
-        const size_t cellY = static_cast<size_t>((inst.y - minY) / distanceThreshold);
-        gridCells[cellX * gridCellsY + cellY].push_back(inst);
+    // Feature ids so the join compares integers instead of strings
+    std::unordered_map<FeatureType, int> featureIds;
+    std::vector<int> typeIds(instances.size());
+    std::vector<size_t> cellOf(instances.size());
+    std::vector<size_t> cellStart(totalCells + 1, 0);
+    for (size_t i = 0; i < instances.size(); ++i) {
+        typeIds[i] = featureIds.emplace(instances[i].type, static_cast<int>(featureIds.size())).first->second;
+        const size_t cellX = static_cast<size_t>((gridX[i] - minX) / searchRadius);
+        const size_t cellY = static_cast<size_t>((gridY[i] - minY) / searchRadius);
+        cellOf[i] = cellX * gridCellsY + cellY;
+        ++cellStart[cellOf[i] + 1];
+    }
+
+    // Assign instances to grid cells (counting sort into one contiguous array)
+    for (size_t c = 0; c < totalCells; ++c) {
+        cellStart[c + 1] += cellStart[c];
+    }
+    CellForest forest(gridX, gridY, cellSplitThreshold);
+    forest.cellPoints.resize(instances.size());
+    {
+        std::vector<size_t> fill(cellStart.begin(), cellStart.end() - 1);
+        for (size_t i = 0; i < instances.size(); ++i) {
+            forest.cellPoints[fill[cellOf[i]]++] = i;
+        }
+    }
+
+    // Build one quadtree per occupied cell (light cells stay a single leaf)
+    const size_t NO_ROOT = static_cast<size_t>(-1);
+    std::vector<size_t> cellRoot(totalCells, NO_ROOT);
+    for (size_t c = 0; c < totalCells; ++c) {
+        if (cellStart[c] != cellStart[c + 1]) {
+            cellRoot[c] = forest.buildCell(cellStart[c], cellStart[c + 1]);
+        }
     }
 
-    // Check pairs within and between adjacent cells
+    // Geodesic mode: unit vectors in cell order, so leaf runs are contiguous for the kernel
+    std::vector<double> unitX, unitY, unitZ;
+    double maxChordSq = 0.0;
+    if (geodesic) {
+        const double degToRad = std::acos(-1.0) / 180.0;
+        unitX.resize(instances.size());
+        unitY.resize(instances.size());
+        unitZ.resize(instances.size());
+        for (size_t pos = 0; pos < instances.size(); ++pos) {
+            const SpatialInstance& inst = instances[forest.cellPoints[pos]];
+            const double lat = inst.y * degToRad;
+            const double lon = inst.x * degToRad;
+            unitX[pos] = std::cos(lat) * std::cos(lon);
+            unitY[pos] = std::cos(lat) * std::sin(lon);
+            unitZ[pos] = std::sin(lat);
+        }
+        // Great-circle distance d <=> chord 2 * sin(d / 2R); beyond half the circumference every pair qualifies
+        const double angle = distanceThreshold / Constants::EARTH_RADIUS_METERS;
+        const double chord = (angle >= std::acos(-1.0)) ? 2.0 : 2.0 * std::sin(0.5 * angle);
+        maxChordSq = chord * chord;
+    }
+
+    // Seed tasks: each cell with itself and its forward neighbors (avoid duplicate checks)
+    std::vector<JoinTask> pending;
     for (size_t cellX = 0; cellX < gridCellsX; ++cellX) {
         for (size_t cellY = 0; cellY < gridCellsY; ++cellY) {
-            const auto& cell = gridCells[cellX * gridCellsY + cellY];
+            const size_t root = cellRoot[cellX * gridCellsY + cellY];
+            if (root == NO_ROOT) continue;
+
+            pending.push_back({ root, root, true });
+            for (int deltaX = 0; deltaX <= 1; ++deltaX) {
+                for (int deltaY = (deltaX == 0 ? 1 : -1); deltaY <= 1; ++deltaY) {
+                    const size_t neighborCellX = cellX + deltaX;
+                    const size_t neighborCellY = cellY + deltaY;
 
-            // Check pairs within the same cell
-            for (size_t i = 0; i < cell.size(); ++i) {
-                for (size_t j = i + 1; j < cell.size(); ++j) {
-                    if (cell[i].type != cell[j].type && euclideanDist(cell[i], cell[j]) <= distanceThreshold) {
-                        neighborPairs.emplace_back(cell[i], cell[j]);
+                    // Bounds check: ensure neighbor cell is within grid
+                    if (neighborCellX < gridCellsX && neighborCellY < gridCellsY) {
+                        const size_t neighborRoot = cellRoot[neighborCellX * gridCellsY + neighborCellY];
+                        if (neighborRoot != NO_ROOT) {
+                            pending.push_back({ root, neighborRoot, false });
+                        }
                     }
                 }
-                
-                // Check pairs with adjacent cells (avoid duplicate checks)
-                for (int deltaX = 0; deltaX <= 1; ++deltaX) {
-                    for (int deltaY = (deltaX == 0 ? 1 : -1); deltaY <= 1; ++deltaY) {
-                        if (deltaX == 0 && deltaY == 0) {
-                            continue;
-                        }
-                        
-                        const size_t neighborCellX = cellX + deltaX;
-                        const size_t neighborCellY = cellY + deltaY;
-                        
-                        // Bounds check: ensure neighbor cell is within grid
-                        if (neighborCellX < gridCellsX && neighborCellY < gridCellsY) {
-                            const auto& neighborCell = gridCells[neighborCellX * gridCellsY + neighborCellY];
-                            for (const auto& neighborInst : neighborCell) {
-                                if (cell[i].type != neighborInst.type && euclideanDist(cell[i], neighborInst) <= distanceThreshold) {
-                                    neighborPairs.emplace_back(cell[i], neighborInst);
-                                }
-                            }
+            }
+        }
+    }
+
+    // Split heavy tasks so one hotspot does not serialize the join
+    const size_t heavyWork = cellSplitThreshold * cellSplitThreshold;
+    std::vector<JoinTask> tasks;
+    tasks.reserve(pending.size());
+    std::array<JoinTask, 10> subtasks;
+    size_t subtaskCount = 0;
+    while (!pending.empty()) {
+        const JoinTask task = pending.back();
+        pending.pop_back();
+
+        const size_t work = forest.nodes[task.nodeA].size() * forest.nodes[task.nodeB].size();
+        if (work <= heavyWork) {
+            tasks.push_back(task);
+            continue;
+        }
+        switch (forest.classify(task, searchRadius, !geodesic, subtasks, subtaskCount)) {
+            case JoinAction::SKIP:
+                break;
+            case JoinAction::SPLIT:
+                pending.insert(pending.end(), subtasks.begin(), subtasks.begin() + subtaskCount);
+                break;
+            default:
+                tasks.push_back(task);
+                break;
+        }
+    }
+
+    // Process tasks in parallel, each into its own buffer
+    std::vector<std::vector<std::pair<SpatialInstance, SpatialInstance>>> taskPairs(tasks.size());
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (long long t = 0; t < static_cast<long long>(tasks.size()); ++t) {
+        auto& out = taskPairs[t];
+        std::vector<JoinTask> stack = { tasks[t] };
+        std::array<JoinTask, 10> children;
+        size_t childCount = 0;
+        std::vector<unsigned char> within;
+
+        while (!stack.empty()) {
+            const JoinTask task = stack.back();
+            stack.pop_back();
+            const JoinAction action = forest.classify(task, searchRadius, !geodesic, children, childCount);
+            if (action == JoinAction::SKIP) continue;
+            if (action == JoinAction::SPLIT) {
+                stack.insert(stack.end(), children.begin(), children.begin() + childCount);
+                continue;
+            }
+
+            const QuadNode& a = forest.nodes[task.nodeA];
+            const QuadNode& b = forest.nodes[task.nodeB];
+
+            // Geodesic leaves (always SCAN): confirm with the great-circle kernel
+            if (geodesic) {
+                within.resize(b.size());
+                for (size_t i = a.begin; i < a.end; ++i) {
+                    const size_t p = forest.cellPoints[i];
+                    const size_t firstJ = task.selfJoin ? i + 1 : b.begin;
+                    chordKernel(unitX.data(), unitY.data(), unitZ.data(), i, firstJ, b.end, maxChordSq, within.data());
+                    for (size_t j = firstJ; j < b.end; ++j) {
+                        const size_t q = forest.cellPoints[j];
+                        // Neighbors farther apart in x than the threshold bound only meet across
+                        // the seam (reported below); skipping them here avoids duplicates
+                        if (within[j - firstJ] && typeIds[p] != typeIds[q] &&
+                            std::abs(gridX[p] - gridX[q]) <= searchRadius) {
+                            out.emplace_back(instances[p], instances[q]);
                         }
                     }
                 }
+                continue;
+            }
+
+            // Planar: WHOLE and SCAN differ only in whether the distance has to be checked
+            const bool checkDistance = (action == JoinAction::SCAN);
+            for (size_t i = a.begin; i < a.end; ++i) {
+                const size_t p = forest.cellPoints[i];
+                for (size_t j = (task.selfJoin ? i + 1 : b.begin); j < b.end; ++j) {
+                    const size_t q = forest.cellPoints[j];
+                    if (typeIds[p] == typeIds[q]) continue;
+                    if (checkDistance && euclideanDist(instances[p], instances[q]) > distanceThreshold) continue;
+                    out.emplace_back(instances[p], instances[q]);
+                }
             }
         }
     }
 
+    // Geodesic seam: a pair whose shorter way round crosses the seam of the projection is
+    // about wrapWidth apart on the plane. Both points then lie within searchRadius of the
+    // edge x = -wrapWidth / 2 resp. +wrapWidth / 2, so only those two strips are joined.
+    std::vector<std::pair<SpatialInstance, SpatialInstance>> seamPairs;
+    if (geodesic) {
+        const double halfWidth = 0.5 * wrapWidth;
+        std::vector<size_t> leftStrip, rightStrip;
+        for (size_t i = 0; i < instances.size(); ++i) {
+            if (gridX[i] + halfWidth <= searchRadius) leftStrip.push_back(i);
+            if (halfWidth - gridX[i] <= searchRadius) rightStrip.push_back(i);
+        }
+        std::sort(rightStrip.begin(), rightStrip.end(), [&gridY](size_t a, size_t b) { return gridY[a] < gridY[b]; });
+
+        const double degToRad = std::acos(-1.0) / 180.0;
+        const auto chordSq = [&instances, degToRad](size_t p, size_t q) {
+            const double latP = instances[p].y * degToRad, lonP = instances[p].x * degToRad;
+            const double latQ = instances[q].y * degToRad, lonQ = instances[q].x * degToRad;
+            const double dx = std::cos(latP) * std::cos(lonP) - std::cos(latQ) * std::cos(lonQ);
+            const double dy = std::cos(latP) * std::sin(lonP) - std::cos(latQ) * std::sin(lonQ);
+            const double dz = std::sin(latP) - std::sin(latQ);
+            return dx * dx + dy * dy + dz * dz;
+        };
+        for (const size_t p : leftStrip) {
+            // |Δlat| is bounded by the distance as well
+            auto it = std::lower_bound(rightStrip.begin(), rightStrip.end(), gridY[p] - searchRadius,
+                [&gridY](size_t q, double y) { return gridY[q] < y; });
+            for (; it != rightStrip.end() && gridY[*it] <= gridY[p] + searchRadius; ++it) {
+                const size_t q = *it;
+                const double planeDx = gridX[q] - gridX[p];
+                if (planeDx <= searchRadius || wrapWidth - planeDx > searchRadius) continue;  // Not across the seam
+                if (typeIds[p] == typeIds[q] || chordSq(p, q) > maxChordSq) continue;
+                seamPairs.emplace_back(instances[p], instances[q]);
+            }
+        }
+    }
+
+    size_t totalPairs = seamPairs.size();
+    for (const auto& pairs : taskPairs) totalPairs += pairs.size();
+    neighborPairs.reserve(totalPairs);
+    for (auto& pairs : taskPairs) {
+        neighborPairs.insert(neighborPairs.end(),
+            std::make_move_iterator(pairs.begin()), std::make_move_iterator(pairs.end()));
+    }
+    neighborPairs.insert(neighborPairs.end(),
+        std::make_move_iterator(seamPairs.begin()), std::make_move_iterator(seamPairs.end()));
+
     return neighborPairs;
-}
\ No newline at end of file
+}
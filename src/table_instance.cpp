@@ -0,0 +1,36 @@
+/**
+ * @file table_instance.cpp
+ * @brief Implementation of the ordinal -> instance lookup for packed table instances
+ */
+
+#include "table_instance.h"
+
+InstanceLookup::InstanceLookup(const NRTree& orderedNRTree) {
+    const NRNode* root = orderedNRTree.getRoot();
+    if (!root) return;
+
+    // Level 2 holds the star centers, level 4 their neighbors
+    for (const auto* featureNode : root->children) {
+        for (const auto* instanceNode : featureNode->children) {
+            add(instanceNode->data);
+            for (const auto* neighborFeatureNode : instanceNode->children) {
+                if (neighborFeatureNode->children.empty()) continue;
+                for (const auto* neighbor : neighborFeatureNode->children[0]->instanceVector) {
+                    add(neighbor);
+                }
+            }
+        }
+    }
+}
+
+void InstanceLookup::add(const SpatialInstance* instance) {
+    auto& instances = byOrdinal[instance->type];
+    if (instance->ordinal >= instances.size()) instances.resize(instance->ordinal + 1, nullptr);
+    instances[instance->ordinal] = instance;
+}
+
+const SpatialInstance* InstanceLookup::find(const FeatureType& feature, uint32_t ordinal) const {
+    const auto it = byOrdinal.find(feature);
+    if (it == byOrdinal.end() || ordinal >= it->second.size()) return nullptr;
+    return it->second[ordinal];
+}
@@ -0,0 +1,76 @@
+/**
+ * @file table_spill.cpp
+ * @brief Implementation of table instance spilling
+ */
+
+#include "table_spill.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// 64-bit seek, so level files larger than 2 GB work on every platform
+bool seekTo(std::FILE* file, int64_t offset) {
+#if defined(_MSC_VER)
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+}
+
+SpilledTables::SpilledTables() : file(std::tmpfile()) {
+    if (!file) {
+        std::cerr << "Warning: cannot create a temporary file for spilling table instances.\n";
+    }
+}
+
+SpilledTables::~SpilledTables() {
+    if (file) std::fclose(file);
+}
+
+bool SpilledTables::spill(const Colocation& pattern, const PackedTable& rows) {
+    if (!file) return false;
+    std::lock_guard<std::mutex> lock(fileMutex);
+
+    const PackedTable::Storage& ordinals = rows.data();
+    if (!seekTo(file, endOffset)) return false;
+    if (std::fwrite(ordinals.data(), sizeof(uint32_t), ordinals.size(), file) != ordinals.size()) return false;
+
+    entries[pattern] = Entry{ endOffset, rows.size() };
+    endOffset += static_cast<int64_t>(ordinals.size() * sizeof(uint32_t));
+    return true;
+}
+
+PackedTable SpilledTables::load(const Colocation& pattern) const {
+    const auto it = entries.find(pattern);
+    if (it == entries.end() || !file) {
+        throw std::logic_error("load of a table instance that was not spilled");
+    }
+
+    PackedTable rows(pattern.size());
+    PackedTable::Storage& ordinals = rows.data();
+    ordinals.resize(it->second.rowCount * pattern.size());
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (!seekTo(file, it->second.offset) ||
+        std::fread(ordinals.data(), sizeof(uint32_t), ordinals.size(), file) != ordinals.size()) {
+        throw std::runtime_error("cannot read back a spilled table instance ("
+            + std::to_string(it->second.rowCount) + " rows at offset " + std::to_string(it->second.offset) + ")");
+    }
+    return rows;
+}
+
+
+size_t estimateTableBytes(const PackedTable& rows, const ExtensionTable* extensions) {
+    size_t bytes = rows.memoryBytes();
+
+    if (extensions) {
+        for (const auto& rowSets : extensions->sets) {
+            bytes += sizeof(rowSets) + rowSets.capacity() * sizeof(ExtensionTable::InstanceSet);
+            for (const auto& set : rowSets) bytes += set.capacity() * sizeof(const SpatialInstance*);
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file telemetry.cpp
+ * @brief Implementation of the process resource telemetry
+ */
+
+#include "telemetry.h"
+#include <fstream>
+#include <sstream>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+namespace {
+
+#if defined(_WIN32)
+
+double fileTimeSeconds(const FILETIME& time) {
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return static_cast<double>(value.QuadPart) * 1e-7;  // 100 ns units
+}
+
+#else
+
+double timevalSeconds(const timeval& time) {
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) * 1e-6;
+}
+
+#endif
+
+#if defined(__linux__)
+
+// VmRSS and VmHWM of /proc/self/status in MB (left unchanged if a line is missing)
+void readProcStatus(double& rssMB, double& peakMB) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        const bool isRSS = line.compare(0, 6, "VmRSS:") == 0;
+        const bool isPeak = line.compare(0, 6, "VmHWM:") == 0;
+        if (!isRSS && !isPeak) continue;
+        std::istringstream fields(line.substr(6));
+        double kilobytes = 0;
+        fields >> kilobytes;
+        (isRSS ? rssMB : peakMB) = kilobytes / 1024.0;
+    }
+}
+
+#endif
+
+}
+
+
+ResourceUsage sampleResourceUsage() {
+    ResourceUsage usage;
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory))) {
+        usage.currentRSSMB = static_cast<double>(memory.WorkingSetSize) / (1024.0 * 1024.0);
+        usage.peakRSSMB = static_cast<double>(memory.PeakWorkingSetSize) / (1024.0 * 1024.0);
+        usage.minorFaults = static_cast<int64_t>(memory.PageFaultCount);
+    }
+    FILETIME creation, exit, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        usage.userCpuSeconds = fileTimeSeconds(user);
+        usage.systemCpuSeconds = fileTimeSeconds(kernel);
+    }
+#else
+    rusage resources;
+    if (getrusage(RUSAGE_SELF, &resources) == 0) {
+        usage.userCpuSeconds = timevalSeconds(resources.ru_utime);
+        usage.systemCpuSeconds = timevalSeconds(resources.ru_stime);
+        usage.minorFaults = resources.ru_minflt;
+        usage.majorFaults = resources.ru_majflt;
+        usage.voluntaryContextSwitches = resources.ru_nvcsw;
+        usage.involuntaryContextSwitches = resources.ru_nivcsw;
+#if defined(__APPLE__)
+        usage.peakRSSMB = static_cast<double>(resources.ru_maxrss) / (1024.0 * 1024.0);  // bytes
+#else
+        usage.peakRSSMB = static_cast<double>(resources.ru_maxrss) / 1024.0;             // kilobytes
+#endif
+    }
+#if defined(__linux__)
+    readProcStatus(usage.currentRSSMB, usage.peakRSSMB);
+#endif
+#endif
+    return usage;
+}
+
+
+MemorySampler::~MemorySampler() {
+    stop();
+}
+
+void MemorySampler::start(unsigned intervalMs) {
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    if (running) return;
+    startTime = std::chrono::steady_clock::now();
+    samples.clear();
+    record();
+    if (intervalMs == 0) return;
+
+    running = true;
+    worker = std::thread([this, intervalMs]() {
+        std::unique_lock<std::mutex> workerLock(sampleMutex);
+        while (!stopSignal.wait_for(workerLock, std::chrono::milliseconds(intervalMs), [this]() { return !running; })) {
+            record();
+        }
+    });
+}
+
+void MemorySampler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(sampleMutex);
+        if (!running) return;
+        running = false;
+        record();
+    }
+    stopSignal.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void MemorySampler::setStage(const std::string& stage) {
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    currentStage = stage;
+    if (startTime != std::chrono::steady_clock::time_point()) record();
+}
+
+std::vector<MemorySample> MemorySampler::timeline() const {
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    return samples;
+}
+
+void MemorySampler::record() {
+    MemorySample sample;
+    sample.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    sample.rssMB = sampleResourceUsage().currentRSSMB;
+    sample.stage = currentStage;
+    samples.push_back(std::move(sample));
+}
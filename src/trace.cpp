@@ -0,0 +1,70 @@
+/**
+ * @file trace.cpp
+ * @brief Implementation of the trace-event collector
+ */
+
+#include "trace.h"
+#include "json_util.h"
+#include <fstream>
+#include <iomanip>
+
+std::atomic<bool> Tracer::enabled{ false };
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::start(const std::string& path) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    outputPath = path;
+    origin = std::chrono::steady_clock::now();
+    for (auto& buffer : buffers) buffer->events.clear();
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+Tracer::ThreadBuffer& Tracer::threadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffers.emplace_back(new ThreadBuffer{ static_cast<uint32_t>(buffers.size()), {} });
+        buffer = buffers.back().get();
+    }
+    return *buffer;
+}
+
+void Tracer::record(std::string name, std::chrono::steady_clock::time_point begin,
+    std::chrono::steady_clock::time_point end) {
+    Event event;
+    event.name = std::move(name);
+    event.beginUs = std::chrono::duration<double, std::micro>(begin - origin).count();
+    event.durationUs = std::chrono::duration<double, std::micro>(end - begin).count();
+    threadBuffer().events.push_back(std::move(event));
+}
+
+bool Tracer::finish() {
+    if (!enabled.exchange(false)) return false;
+
+    // Spans of worker threads are complete here: every parallel region has joined
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::ofstream out(outputPath);
+    if (!out.is_open()) return false;
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for (const auto& buffer : buffers) {
+        out << (first ? "" : ",\n")
+            << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->tid
+            << ", \"args\": {\"name\": \"" << (buffer->tid == 0 ? "main" : "worker " + std::to_string(buffer->tid)) << "\"}}";
+        first = false;
+        for (const Event& event : buffer->events) {
+            out << ",\n{\"name\": " << jsonString(event.name) << ", \"cat\": \"colocation\", \"ph\": \"X\""
+                << ", \"pid\": 1, \"tid\": " << buffer->tid
+                << std::fixed << std::setprecision(3)
+                << ", \"ts\": " << event.beginUs << ", \"dur\": " << event.durationUs << "}";
+        }
+        buffer->events.clear();
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
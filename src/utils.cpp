@@ -7,12 +7,26 @@
 #include "constants.h"
 #include <set>
 #include <chrono>
-#include <windows.h>
-#include <psapi.h>
 #include <iostream> 
 #include <iomanip>
 #include <algorithm> 
 #include <cmath>    
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Count set bits of the participation bitmap
+size_t InstanceBitmap::count() const {
+    size_t total = 0;
+    for (const uint64_t word : words) {
+#if defined(_MSC_VER)
+        total += static_cast<size_t>(__popcnt64(word));
+#else
+        total += static_cast<size_t>(__builtin_popcountll(word));
+#endif
+    }
+    return total;
+}
 
 // Get all unique feature types from instances
 std::vector<FeatureType> getAllObjectTypes(const std::vector<SpatialInstance>& instances) {
@@ -33,11 +47,7 @@ std::map<FeatureType, int> countInstancesByFeature(const std::vector<SpatialInst
     std::map<FeatureType, int> featureCount;
     
     for (const auto& instance : instances) {
-        // Extract feature type from instance ID
-        // Assumes ID format is: FeatureType + Number (e.g., "A1", "B2")
-        // Takes first character as feature type
-        FeatureType featureType = instance.id.substr(0, 1);
-        featureCount[featureType]++;
+        featureCount[instance.type]++;
     }
     
     return featureCount;
@@ -60,30 +70,19 @@ std::optional<SpatialInstance> getInstanceByID(
     return (it != instances.end()) ? std::optional<SpatialInstance>(*it) : std::nullopt;
 }
 
-// Step 2: Sorting features in ascending order of the quantity of instances
-std::vector<FeatureType> featureSort(const std::vector<FeatureType>& featureSet, const std::vector<SpatialInstance>& instances) {
-    // Generate feature counts using the helper function
-    const std::map<FeatureType, int> featureCounts = countInstancesByFeature(instances);
-    
-    // Create a copy to sort (input is const)
-    std::vector<FeatureType> sortedFeatures = featureSet;
-
-    // Sort logic based on Algorithm 1 Step 2
-    // Ascending order of instance counts
-    std::sort(sortedFeatures.begin(), sortedFeatures.end(), 
-        [&featureCounts](const FeatureType& a, const FeatureType& b) {
-            const int countA = (featureCounts.find(a) != featureCounts.end()) ? featureCounts.at(a) : 0;
-            const int countB = (featureCounts.find(b) != featureCounts.end()) ? featureCounts.at(b) : 0;
-            
-            // Primary sort key: count (ascending)
-            if (countA != countB) {
-                return countA < countB;
-            }
-            // Secondary sort key: lexicographical (for stability/determinism)
-            return a < b;
-        }
-    );
-    return sortedFeatures;
+// Feature order of Algorithm 1 Step 2: ascending instance count, ties broken by name
+bool featureLess(const FeatureType& a, const FeatureType& b, const std::map<FeatureType, int>& featureCounts) {
+    const auto itA = featureCounts.find(a);
+    const auto itB = featureCounts.find(b);
+    const int countA = (itA != featureCounts.end()) ? itA->second : 0;
+    const int countB = (itB != featureCounts.end()) ? itB->second : 0;
+
+    // Primary sort key: count (ascending)
+    if (countA != countB) {
+        return countA < countB;
+    }
+    // Secondary sort key: lexicographical (for stability/determinism)
+    return a < b;
 }
 
 // Step 3: Calculating delta for the spatial dataset
@@ -244,6 +243,85 @@ double calculateRareIntensity(
     return std::exp(-numerator / denominator);
 }
 
+// Precompute 1 / RI(f, C) for every (feature, f_min) pair of ranks
+RareWeightTable::RareWeightTable(
+    const std::vector<FeatureType>& sortedFeatures,
+    const std::map<FeatureType, int>& featureCounts,
+    double delta)
+    : numFeatures(sortedFeatures.size()), weights(sortedFeatures.size() * sortedFeatures.size(), 0.0),
+      rankedFeatures(sortedFeatures), counts(rankedCounts(sortedFeatures, featureCounts)), sourceDelta(delta)
+{
+    // Same guards as calculateRareIntensity: no dispersion or no instances => RI = 0
+    if (delta <= Constants::EPSILON_DELTA) return;
+
+    const double denominator = 2.0 * delta * delta;
+    for (size_t f = 0; f < numFeatures; ++f) {
+        for (size_t fmin = 0; fmin < numFeatures; ++fmin) {
+            if (counts[fmin] <= 0) continue;
+            const double v_val = static_cast<double>(counts[f]) / static_cast<double>(counts[fmin]);
+            const double ri = std::exp(-std::pow(v_val - 1.0, 2) / denominator);
+            weights[f * numFeatures + fmin] = (ri > Constants::EPSILON_SMALL) ? 1.0 / ri : 0.0;
+        }
+    }
+}
+
+// Compares the ranking and delta the table was built from with the given ones
+bool RareWeightTable::builtFrom(
+    const std::vector<FeatureType>& sortedFeatures,
+    const std::map<FeatureType, int>& featureCounts,
+    double delta) const
+{
+    return delta == sourceDelta && sortedFeatures == rankedFeatures
+        && rankedCounts(sortedFeatures, featureCounts) == counts;
+}
+
+
+std::vector<int> RareWeightTable::rankedCounts(
+    const std::vector<FeatureType>& sortedFeatures,
+    const std::map<FeatureType, int>& featureCounts)
+{
+    std::vector<int> ranked;
+    ranked.reserve(sortedFeatures.size());
+    for (const auto& feature : sortedFeatures) {
+        const auto it = featureCounts.find(feature);
+        ranked.push_back(it != featureCounts.end() ? it->second : 0);
+    }
+    return ranked;
+}
+
+
+// WPI of all patterns of a level; the inner loop runs over patterns so it vectorizes
+void RareWeightTable::levelWPI(
+    const std::vector<uint32_t>& ranks,
+    const std::vector<double>& participationRatios,
+    size_t patternSize,
+    std::vector<double>& wpi) const
+{
+    const size_t numPatterns = patternSize ? ranks.size() / patternSize : 0;
+    wpi.assign(numPatterns, 0.0);
+    if (numPatterns == 0) return;
+
+    const uint32_t* rankData = ranks.data();
+    const double* prData = participationRatios.data();
+    const double* weightData = weights.data();
+    double* out = wpi.data();
+    const size_t m = numFeatures;
+
+#pragma omp simd
+    for (size_t c = 0; c < numPatterns; ++c) {
+        const size_t base = c * patternSize;
+        out[c] = prData[base] * weightData[rankData[base] * m + rankData[base]];
+    }
+    for (size_t j = 1; j < patternSize; ++j) {
+#pragma omp simd
+        for (size_t c = 0; c < numPatterns; ++c) {
+            const size_t base = c * patternSize;
+            const double wpr = prData[base + j] * weightData[rankData[base + j] * m + rankData[base]];
+            out[c] = wpr < out[c] ? wpr : out[c];
+        }
+    }
+}
+
 // Calculate Participation Index (PI)
 // PI(C) = min_{i=1 to k} { PR(fi, C) }
 double calculatePI(
@@ -272,6 +350,26 @@ double calculatePI(
     
     return minPR;
 }
+std::vector<const SpatialInstance*> intersectByOrdinal(
+    const std::vector<const SpatialInstance*>& a,
+    const std::vector<const SpatialInstance*>& b)
+{
+    std::vector<const SpatialInstance*> result;
+    result.reserve(std::min(a.size(), b.size()));
+
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i]->ordinal < b[j]->ordinal) ++i;
+        else if (b[j]->ordinal < a[i]->ordinal) ++j;
+        else {
+            result.push_back(a[i]);
+            ++i;
+            ++j;
+        }
+    }
+    return result;
+}
+
 void findCombinations(
     const std::vector<FeatureType>& candidatePattern,
     int typeIndex,
@@ -297,16 +395,18 @@ void findCombinations(
 }
 
 
+std::string patternName(const Colocation& pattern) {
+    std::string name = "{";
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        if (i) name += ", ";
+        name += pattern[i];
+    }
+    return name + "}";
+}
+
+
 void printDuration(const std::string& stepName, std::chrono::high_resolution_clock::time_point start, std::chrono::high_resolution_clock::time_point end) {
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
     std::cout << "[PERF] " << stepName << ": " << duration << " ms\n";
 }
 
-
-double getMemoryUsageMB() {
-    PROCESS_MEMORY_COUNTERS pmc;
-    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
-        return static_cast<double>(pmc.WorkingSetSize) / (1024.0 * 1024.0);
-    }
-    return 0.0;
-}
\ No newline at end of file